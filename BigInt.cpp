@@ -1,46 +1,297 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
-#include <iomanip>
+#include <string_view>
 #include <stdexcept>
 #include <algorithm>
 #include <cstdint>
 #include <type_traits>
+#include <charconv>
+#include "instrumentation.h"
 
 class BigInt {
 private:
     std::vector<int64_t> num;
     bool _sign;
     static constexpr int64_t base = 1000000000000000000ll;
-    static constexpr size_t KARATSUBA_THRESHOLD = 1024;
+    static inline size_t KARATSUBA_THRESHOLD = 1024;
+    static inline size_t NTT_THRESHOLD = 128;
+    static constexpr int64_t ntt_base = 1000000000ll;
+    static constexpr size_t NTT_MAX_SIZE = size_t(1) << 23;
+    static constexpr size_t NEWTON_THRESHOLD = 384;
+    static constexpr size_t NEWTON_BASE_PRECISION = 16;
 
-    void addAbsolute(const BigInt& other) {
+    template <uint32_t MOD>
+    class modint {
+    private:
+        uint32_t val;
+    public:
+        modint() : val(0) {}
+        modint(uint64_t v) : val(uint32_t(v % MOD)) {}
+        uint32_t value() const { return val; }
+        modint& operator+=(const modint& o) { val += o.val; if (val >= MOD) val -= MOD; return *this; }
+        modint& operator-=(const modint& o) { val += MOD - o.val; if (val >= MOD) val -= MOD; return *this; }
+        modint& operator*=(const modint& o) { val = uint32_t(uint64_t(val) * o.val % MOD); return *this; }
+        friend modint operator+(modint a, const modint& b) { return a += b; }
+        friend modint operator-(modint a, const modint& b) { return a -= b; }
+        friend modint operator*(modint a, const modint& b) { return a *= b; }
+        static modint fast_pow(modint x, uint64_t y) {
+            modint r(1);
+            for (; y; y >>= 1, x *= x) if (y & 1) r *= x;
+            return r;
+        }
+    };
+
+    template <uint32_t MOD, uint32_t G>
+    static void ntt(std::vector<modint<MOD>>& a, bool invert) {
+        using m = modint<MOD>;
+        size_t n = a.size();
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) std::swap(a[i], a[j]);
+        }
+        std::vector<m> roots(n / 2);
+        for (size_t len = 2; len <= n; len <<= 1) {
+            m w = m::fast_pow(m(G), (MOD - 1) / len);
+            if (invert) w = m::fast_pow(w, MOD - 2);
+            size_t half = len >> 1;
+            roots[0] = m(1);
+            for (size_t k = 1; k < half; ++k) roots[k] = roots[k - 1] * w;
+            for (size_t i = 0; i < n; i += len) {
+                for (size_t k = 0; k < half; ++k) {
+                    m u = a[i + k], v = a[i + k + half] * roots[k];
+                    a[i + k] = u + v;
+                    a[i + k + half] = u - v;
+                }
+            }
+        }
+        if (invert) {
+            m inv_n = m::fast_pow(m(n), MOD - 2);
+            for (m& x : a) x *= inv_n;
+        }
+    }
+
+    template <uint32_t MOD, uint32_t G>
+    static std::vector<modint<MOD>> ntt_convolve(const std::vector<int64_t>& a, const std::vector<int64_t>& b, size_t sz) {
+        using m = modint<MOD>;
+        std::vector<m> fa(sz), fb(sz);
+        for (size_t i = 0; i < a.size(); ++i) fa[i] = m(uint64_t(a[i]));
+        for (size_t i = 0; i < b.size(); ++i) fb[i] = m(uint64_t(b[i]));
+        ntt<MOD, G>(fa, false);
+        ntt<MOD, G>(fb, false);
+        for (size_t i = 0; i < sz; ++i) fa[i] *= fb[i];
+        ntt<MOD, G>(fa, true);
+        return fa;
+    }
+
+    static std::vector<int64_t> split_limbs(const int64_t* x, size_t n) {
+        std::vector<int64_t> d(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            d[2 * i] = x[i] % ntt_base;
+            d[2 * i + 1] = x[i] / ntt_base;
+        }
+        return d;
+    }
+
+    static bool ntt_fits(size_t nx, size_t ny) {
+        return 2 * (nx + ny) <= NTT_MAX_SIZE;
+    }
+
+    // r[0, nx + ny) = x * y
+    static void ntt_multiply(const int64_t* x, size_t nx, const int64_t* y, size_t ny, int64_t* r) {
+        constexpr uint32_t M1 = 998244353, M2 = 167772161, M3 = 469762049;
+        std::vector<int64_t> a = split_limbs(x, nx), b = split_limbs(y, ny);
+        size_t need = a.size() + b.size() - 1, sz = 1;
+        while (sz < need) sz <<= 1;
+        std::vector<modint<M1>> c1 = ntt_convolve<M1, 3>(a, b, sz);
+        std::vector<modint<M2>> c2 = ntt_convolve<M2, 3>(a, b, sz);
+        std::vector<modint<M3>> c3 = ntt_convolve<M3, 3>(a, b, sz);
+        const modint<M2> inv_m1_m2 = modint<M2>::fast_pow(modint<M2>(M1), M2 - 2);
+        const modint<M3> inv_m1_m3 = modint<M3>::fast_pow(modint<M3>(M1), M3 - 2);
+        const modint<M3> inv_m2_m3 = modint<M3>::fast_pow(modint<M3>(M2), M3 - 2);
+        unsigned __int128 carry = 0;
+        for (size_t i = 0; i < 2 * (nx + ny); ++i) {
+            unsigned __int128 cur = carry;
+            if (i < need) {
+                uint64_t r1 = c1[i].value();
+                modint<M2> x2 = (c2[i] - modint<M2>(r1)) * inv_m1_m2;
+                modint<M3> x3 = ((c3[i] - modint<M3>(r1)) * inv_m1_m3 - modint<M3>(x2.value())) * inv_m2_m3;
+                cur += r1 + (unsigned __int128)x2.value() * M1 + (unsigned __int128)x3.value() * M1 * M2;
+            }
+            int64_t digit = int64_t(cur % ntt_base);
+            carry = cur / ntt_base;
+            if (i & 1) r[i / 2] += digit * ntt_base;
+            else r[i / 2] = digit;
+        }
+    }
+
+    /*
+        Bump allocator for the Karatsuba recursion. A top-level multiply reserves the
+        whole scratch area once (karatsuba_scratch(n) limbs, about 4n) and every level
+        carves its temporaries off the top, releasing them on the way back. The buffer
+        is kept per thread, so repeated multiplies of similar size do not allocate.
+    */
+    struct ScratchArena {
+        std::vector<int64_t> buffer;
+        size_t top = 0;
+        void reserve(size_t limbs) { if (buffer.size() < top + limbs) buffer.resize(top + limbs); }
+        int64_t* take(size_t limbs) { int64_t* p = buffer.data() + top; top += limbs; return p; }
+    };
+
+    static ScratchArena& scratch() {
+        static thread_local ScratchArena arena;
+        return arena;
+    }
+
+    static size_t karatsuba_scratch(size_t n) {
+        size_t total = 0;
+        while (n > KARATSUBA_THRESHOLD) {
+            size_t m = (n + 1) / 2;
+            total += 4 * m + 4;
+            n = m + 1;
+        }
+        return total;
+    }
+
+    // r[0, nr) += a[0, na), returns the carry out of r[nr - 1]
+    static int64_t add_span(int64_t* r, size_t nr, const int64_t* a, size_t na) {
         int64_t carry = 0;
-        size_t n = std::max(num.size(), other.num.size());
+        size_t i = 0;
+        for (; i < na; ++i) {
+            int64_t sum = r[i] + a[i] + carry;
+            carry = sum >= base;
+            r[i] = carry ? sum - base : sum;
+        }
+        for (; carry && i < nr; ++i) {
+            carry = ++r[i] == base;
+            if (carry) r[i] = 0;
+        }
+        return carry;
+    }
+
+    // r[0, nr) -= a[0, na), returns the borrow out of r[nr - 1]
+    static int64_t sub_span(int64_t* r, size_t nr, const int64_t* a, size_t na) {
+        int64_t borrow = 0;
+        size_t i = 0;
+        for (; i < na; ++i) {
+            int64_t diff = r[i] - a[i] - borrow;
+            borrow = diff < 0;
+            r[i] = borrow ? diff + base : diff;
+        }
+        for (; borrow && i < nr; ++i) {
+            borrow = --r[i] < 0;
+            if (borrow) r[i] += base;
+        }
+        return borrow;
+    }
+
+    // r[0, na + nb) += a * b, the sum must fit in na + nb limbs
+    static void add_product_span(int64_t* r, const int64_t* a, size_t na, const int64_t* b, size_t nb) {
+        for (size_t i = 0; i < na; ++i) {
+            if (a[i] == 0) continue;
+            __int128 carry = 0;
+            size_t k = i;
+            for (size_t j = 0; j < nb; ++j, ++k) {
+                __int128 cur = r[k] + __int128(a[i]) * b[j] + carry;
+                carry = cur / base;
+                r[k] = int64_t(cur - carry * base);
+            }
+            for (; carry; ++k) {
+                __int128 cur = r[k] + carry;
+                carry = cur / base;
+                r[k] = int64_t(cur - carry * base);
+            }
+        }
+    }
+
+    // r[0, nx + ny) = x * y, temporaries come from the arena
+    static void multiply_spans(const int64_t* x, size_t nx, const int64_t* y, size_t ny, int64_t* r, ScratchArena& arena) {
+        INSTRUMENT_DEPTH("bigint.multiply_spans");
+        std::fill(r, r + nx + ny, 0);
+        if (nx == 0 || ny == 0) return;
+        size_t n = std::max(nx, ny);
+        if (n >= NTT_THRESHOLD && ntt_fits(nx, ny)) { ntt_multiply(x, nx, y, ny, r); return; }
+        if (n <= KARATSUBA_THRESHOLD) { add_product_span(r, x, nx, y, ny); return; }
+        size_t m = (n + 1) / 2;
+        size_t nx0 = std::min(nx, m), nx1 = nx - nx0, ny0 = std::min(ny, m), ny1 = ny - ny0;
+        size_t mark = arena.top;
+        int64_t* sx = arena.take(m + 1);
+        int64_t* sy = arena.take(m + 1);
+        int64_t* z1 = arena.take(2 * m + 2);
+        multiply_spans(x, nx0, y, ny0, r, arena);
+        size_t nz2 = (nx1 && ny1) ? nx1 + ny1 : 0;
+        if (nz2) multiply_spans(x + nx0, nx1, y + ny0, ny1, r + 2 * m, arena);
+        std::fill(sx, sx + m + 1, 0);
+        std::fill(sy, sy + m + 1, 0);
+        std::copy(x, x + nx0, sx);
+        std::copy(y, y + ny0, sy);
+        add_span(sx, m + 1, x + nx0, nx1);
+        add_span(sy, m + 1, y + ny0, ny1);
+        size_t nsx = m + 1, nsy = m + 1;
+        while (nsx > 0 && sx[nsx - 1] == 0) --nsx;
+        while (nsy > 0 && sy[nsy - 1] == 0) --nsy;
+        std::fill(z1, z1 + 2 * m + 2, 0);
+        multiply_spans(sx, nsx, sy, nsy, z1, arena);
+        sub_span(z1, 2 * m + 2, r, 2 * m);
+        sub_span(z1, 2 * m + 2, r + 2 * m, nz2);
+        size_t nz1 = std::min(2 * m + 2, nx + ny - m);
+        add_span(r + m, nx + ny - m, z1, nz1);
+        arena.top = mark;
+    }
+
+    // |*this| += |other| * base^offset
+    void addAbsolute(const BigInt& other, size_t offset = 0) {
+        if (other.is_zero()) return;
+        size_t n = std::max(num.size(), other.num.size() + offset);
         num.resize(n, 0);
-        for (size_t i = 0; i < n; ++i) {
-            __int128 sum = __int128(num[i]) + (i < other.num.size() ? other.num[i] : 0) + carry;
-            num[i] = int64_t(sum % base);
-            carry = int64_t(sum / base);
+        int64_t carry = 0;
+        size_t i = offset;
+        for (size_t j = 0; j < other.num.size(); ++i, ++j) {
+            int64_t sum = num[i] + other.num[j] + carry;
+            carry = sum >= base;
+            num[i] = carry ? sum - base : sum;
+        }
+        for (; carry && i < n; ++i) {
+            carry = ++num[i] == base;
+            if (carry) num[i] = 0;
         }
         if (carry) num.push_back(carry);
     }
 
+    // |*this| -= |other|, requires |*this| >= |other|
     void subAbsolute(const BigInt& other) {
+        int64_t borrow = 0;
+        size_t i = 0;
+        for (; i < other.num.size(); ++i) {
+            int64_t diff = num[i] - other.num[i] - borrow;
+            borrow = diff < 0;
+            num[i] = borrow ? diff + base : diff;
+        }
+        for (; borrow && i < num.size(); ++i) {
+            borrow = --num[i] < 0;
+            if (borrow) num[i] += base;
+        }
+    }
+
+    // |*this| = |other| - |*this|, requires |other| >= |*this|
+    void rsubAbsolute(const BigInt& other) {
+        num.resize(other.num.size(), 0);
         int64_t borrow = 0;
         for (size_t i = 0; i < num.size(); ++i) {
-            __int128 diff = __int128(num[i]) - (i < other.num.size() ? other.num[i] : 0) - borrow;
-            if (diff < 0) {
-                diff += base;
-                borrow = 1;
-            } else {
-                borrow = 0;
-            }
-            num[i] = int64_t(diff);
+            int64_t diff = other.num[i] - num[i] - borrow;
+            borrow = diff < 0;
+            num[i] = borrow ? diff + base : diff;
         }
     }
 
+    // |*this| += |a| * |b| by schoolbook accumulation
+    void addProductAbsolute(const BigInt& a, const BigInt& b) {
+        num.resize(std::max(num.size(), a.num.size() + b.num.size()) + 1, 0);
+        add_product_span(num.data(), a.num.data(), a.num.size(), b.num.data(), b.num.size());
+    }
+
     void normalize() {
         while (num.size() > 1 && num.back() == 0) num.pop_back();
         if (num.size() == 1 && num[0] == 0) _sign = true;
@@ -56,36 +307,45 @@ private:
         return true;
     }
 
-    std::string to_string() const {
-        std::ostringstream oss;
-        if (!_sign) oss << '-';
-        for (int32_t i = int32_t(num.size()) - 1; i >= 0; --i) {
-            if (i == int32_t(num.size()) - 1)
-                oss << num[i];
-            else
-                oss << std::setw(18) << std::setfill('0') << num[i];
+    static constexpr size_t LIMB_DIGITS = 18;
+
+    static size_t count_digits(int64_t x) {
+        size_t d = 1;
+        while (x >= 10) { x /= 10; ++d; }
+        return d;
+    }
+
+    // writes the lowest `width` decimal digits of x so that the last one lands at end[-1]
+    static void write_digits(char* end, int64_t x, size_t width) {
+        static constexpr char pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        uint64_t v = uint64_t(x);
+        while (width >= 2) {
+            size_t k = size_t(v % 100) * 2;
+            v /= 100;
+            *--end = pairs[k + 1];
+            *--end = pairs[k];
+            width -= 2;
         }
-        return oss.str();
+        if (width) *--end = char('0' + v % 10);
     }
 
-    bool is_zero() const {
-        return num.size() == 1 && num[0] == 0;
+    static int64_t parse_digits(const char* first, const char* last) {
+        int64_t part = 0;
+        for (; first != last; ++first) part = part * 10 + (*first - '0');
+        return part;
     }
 
-    BigInt classic_multiply(const BigInt& a, const BigInt& b) const {
-        BigInt result;
-        result.num.assign(a.num.size() + b.num.size(), 0);
-        for (size_t i = 0; i < a.num.size(); ++i) {
-            __int128 carry = 0;
-            for (size_t j = 0; j < b.num.size() || carry; ++j) {
-                __int128 cur = result.num[i + j] + __int128(a.num[i]) * (j < b.num.size() ? b.num[j] : 0) + carry;
-                result.num[i + j] = int64_t(cur % base);
-                carry = cur / base;
-            }
-        }
-        result._sign = (a._sign == b._sign);
-        result.normalize();
-        return result;
+    std::string to_string() const {
+        std::string s(max_chars(), '\0');
+        s.resize(size_t(to_chars(s.data(), s.data() + s.size()).ptr - s.data()));
+        return s;
+    }
+
+    bool is_zero() const {
+        return num.size() == 1 && num[0] == 0;
     }
 
     BigInt higher_half(const BigInt& x, size_t m) const {
@@ -97,17 +357,6 @@ private:
         return res;
     }
 
-    BigInt lower_half(const BigInt& x, size_t m) const {
-        BigInt res;
-        if (x.num.size() <= m)
-            res.num = x.num;
-        else
-            res.num.assign(x.num.begin(), x.num.begin() + m);
-        res._sign = true;
-        res.normalize();
-        return res;
-    }
-
     BigInt shift_left(const BigInt& x, size_t m) const {
         if (x.is_zero()) return BigInt(0);
         BigInt res = x;
@@ -116,155 +365,413 @@ private:
     }
 
     BigInt karatsuba(const BigInt& x, const BigInt& y) const {
-        size_t n = std::max(x.num.size(), y.num.size());
-        if (n <= KARATSUBA_THRESHOLD) return classic_multiply(x, y);
-        size_t m = n / 2;
-        BigInt x1 = higher_half(x, m);
-        BigInt x0 = lower_half(x, m);
-        BigInt y1 = higher_half(y, m);
-        BigInt y0 = lower_half(y, m);
-        BigInt z0 = karatsuba(x0, y0);
-        BigInt z2 = karatsuba(x1, y1);
-        BigInt z1 = karatsuba(x0 + x1, y0 + y1) - z2 - z0;
-        BigInt res = shift_left(z2, 2 * m) + shift_left(z1, m) + z0;
+        size_t nx = x.num.size(), ny = y.num.size();
+        ScratchArena& arena = scratch();
+        size_t mark = arena.top;
+        arena.reserve(karatsuba_scratch(std::max(nx, ny)));
+        BigInt res;
+        res.num.resize(nx + ny);
+        multiply_spans(x.num.data(), nx, y.num.data(), ny, res.num.data(), arena);
+        arena.top = mark;
         res._sign = (x._sign == y._sign);
         res.normalize();
         return res;
     }
 
+    void assign_small(int64_t x) {
+        _sign = x >= 0;
+        uint64_t v = _sign ? uint64_t(x) : 0 - uint64_t(x);
+        num.clear();
+        do { num.push_back(int64_t(v % base)); v /= base; } while (v);
+    }
+
+    // |*this| += v for 0 <= v < base
+    void addSmallAbsolute(int64_t v) {
+        for (size_t i = 0; v; ++i) {
+            if (i == num.size()) num.push_back(0);
+            int64_t sum = num[i] + v;
+            v = sum >= base;
+            num[i] = v ? sum - base : sum;
+        }
+    }
+
+    // |*this| -= v for 0 <= v < base, requires |*this| >= v
+    void subSmallAbsolute(int64_t v) {
+        for (size_t i = 0; v; ++i) {
+            int64_t diff = num[i] - v;
+            v = diff < 0;
+            num[i] = v ? diff + base : diff;
+        }
+    }
+
+    // |*this| *= v for 0 <= v < base
+    void mulSmallAbsolute(int64_t v) {
+        __int128 carry = 0;
+        for (int64_t& limb : num) {
+            __int128 cur = __int128(limb) * v + carry;
+            carry = cur / base;
+            limb = int64_t(cur - carry * base);
+        }
+        if (carry) num.push_back(int64_t(carry));
+    }
+
+    static bool fits_limb(int64_t x) { return x > -base && x < base; }
+
+    BigInt& add_small(int64_t x) {
+        if (!fits_limb(x)) return *this += BigInt(x);
+        bool s = x >= 0;
+        int64_t v = s ? x : -x;
+        if (s == _sign || is_zero()) {
+            if (is_zero()) _sign = s;
+            addSmallAbsolute(v);
+        } else if (num.size() > 1 || num[0] >= v) {
+            subSmallAbsolute(v);
+        } else {
+            num[0] = v - num[0];
+            _sign = s;
+        }
+        normalize();
+        return *this;
+    }
+
+    BigInt& mul_small(int64_t x) {
+        if (!fits_limb(x)) return *this *= BigInt(x);
+        if (x < 0) { _sign = !_sign; x = -x; }
+        mulSmallAbsolute(x);
+        normalize();
+        return *this;
+    }
+
+    BigInt& div_small(int64_t x) {
+        if (x == 0) throw std::runtime_error("Division by zero");
+        if (!fits_limb(x)) return *this /= BigInt(x);
+        bool signRes = (_sign == (x > 0));
+        divmod_small(*this, x < 0 ? -x : x, *this);
+        _sign = signRes;
+        normalize();
+        return *this;
+    }
+
+    BigInt& mod_small(int64_t x) {
+        if (x == 0) throw std::runtime_error("Modulo by zero");
+        if (!fits_limb(x)) return *this %= BigInt(x);
+        int64_t d = x < 0 ? -x : x;
+        __int128 rem = 0;
+        for (int32_t i = int32_t(num.size()) - 1; i >= 0; --i) rem = (rem * base + num[i]) % d;
+        assign_small(_sign ? int64_t(rem) : -int64_t(rem));
+        return *this;
+    }
+
+    void negate() { if (!is_zero()) _sign = !_sign; }
+
+    static BigInt power_of_base(size_t k) {
+        BigInt res;
+        res.num.assign(k + 1, 0);
+        res.num[k] = 1;
+        return res;
+    }
+
+    static int64_t divmod_small(const BigInt& a, int64_t d, BigInt& q) {
+        q.num.resize(a.num.size());
+        q._sign = true;
+        __int128 rem = 0;
+        for (int32_t i = int32_t(a.num.size()) - 1; i >= 0; --i) {
+            __int128 cur = rem * base + a.num[i];
+            q.num[i] = int64_t(cur / d);
+            rem = cur % d;
+        }
+        q.normalize();
+        return int64_t(rem);
+    }
+
+    static std::vector<int64_t> multiply_small(const std::vector<int64_t>& x, int64_t d) {
+        std::vector<int64_t> res(x.size() + 1, 0);
+        __int128 carry = 0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            __int128 cur = __int128(x[i]) * d + carry;
+            res[i] = int64_t(cur % base);
+            carry = cur / base;
+        }
+        res[x.size()] = int64_t(carry);
+        return res;
+    }
+
+    // Knuth, TAOCP vol. 2, 4.3.1 Algorithm D; a >= b >= 0 and b has at least two limbs
+    static void knuth_divmod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+        size_t n = b.num.size(), m = a.num.size() - n;
+        int64_t d = base / (b.num.back() + 1);
+        std::vector<int64_t> u = multiply_small(a.num, d), v = multiply_small(b.num, d);
+        v.pop_back();
+        q.num.assign(m + 1, 0);
+        q._sign = true;
+        for (int32_t j = int32_t(m); j >= 0; --j) {
+            __int128 top = __int128(u[j + n]) * base + u[j + n - 1];
+            __int128 qhat = top / v[n - 1], rhat = top % v[n - 1];
+            while (qhat >= base || qhat * v[n - 2] > rhat * base + u[j + n - 2]) {
+                --qhat;
+                rhat += v[n - 1];
+                if (rhat >= base) break;
+            }
+            __int128 carry = 0, borrow = 0;
+            for (size_t i = 0; i < n; ++i) {
+                __int128 p = qhat * v[i] + carry;
+                carry = p / base;
+                __int128 t = __int128(u[i + j]) - p % base - borrow;
+                borrow = t < 0;
+                u[i + j] = int64_t(t < 0 ? t + base : t);
+            }
+            __int128 t = __int128(u[j + n]) - carry - borrow;
+            u[j + n] = int64_t(t);
+            if (t < 0) {
+                --qhat;
+                carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    __int128 sum = __int128(u[i + j]) + v[i] + carry;
+                    u[i + j] = int64_t(sum % base);
+                    carry = sum / base;
+                }
+                u[j + n] += int64_t(carry);
+            }
+            q.num[j] = int64_t(qhat);
+        }
+        q.normalize();
+        BigInt rem;
+        rem.num.assign(u.begin(), u.begin() + n);
+        rem._sign = true;
+        rem.normalize();
+        divmod_small(rem, d, r);
+    }
+
+    // approximates base^(v.num.size() + p) / v for v > 0 by Newton iteration, off by a few units at most
+    BigInt reciprocal(const BigInt& v, size_t p) const {
+        size_t nv = v.num.size();
+        if (nv > p + 1) return reciprocal(higher_half(v, nv - p - 1), p);
+        if (p <= NEWTON_BASE_PRECISION) {
+            BigInt q, r;
+            if (nv == 1) divmod_small(power_of_base(nv + p), v.num[0], q);
+            else knuth_divmod(power_of_base(nv + p), v, q, r);
+            return q;
+        }
+        size_t h = p / 2 + 1;
+        BigInt y = reciprocal(v, h);
+        BigInt e = power_of_base(nv + h) - v * y;
+        BigInt correction = higher_half(y * e, nv + 2 * h - p);
+        if (!e._sign) correction = -correction;
+        if (correction._sign) return add_shifted(correction, y, p - h);
+        BigInt res = shift_left(y, p - h);
+        res.subAbsolute(correction);
+        res.normalize();
+        return res;
+    }
+
+    void newton_divmod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) const {
+        size_t n = b.num.size(), p = a.num.size() - n + 2;
+        q = higher_half(a * reciprocal(b, p), n + p);
+        r = a - q * b;
+        while (!r._sign) { q -= 1; r += b; }
+        while (r >= b) { q += 1; r -= b; }
+    }
+
+    void divmod_abs(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) const {
+        if (a.num.size() < b.num.size() || less_abs(a, b)) { q = BigInt(0); r = a; r._sign = true; return; }
+        if (b.num.size() == 1) { r = BigInt(divmod_small(a, b.num[0], q)); return; }
+        if (b.num.size() >= NEWTON_THRESHOLD && a.num.size() - b.num.size() >= NEWTON_THRESHOLD) newton_divmod(a.abs(), b.abs(), q, r);
+        else knuth_divmod(a, b, q, r);
+    }
+
+    static bool less_abs(const BigInt& a, const BigInt& b) {
+        if (a.num.size() != b.num.size()) return a.num.size() < b.num.size();
+        for (int32_t i = int32_t(a.num.size()) - 1; i >= 0; --i) {
+            if (a.num[i] != b.num[i]) return a.num[i] < b.num[i];
+        }
+        return false;
+    }
+
 public:
-    BigInt(): num{0}, _sign(true) {}
-    BigInt(int64_t x): num(), _sign(true) {
-        if (x < 0) { _sign = false; x = -x; }
-        while (x) { num.push_back(x % base); x /= base; }
-        if (num.empty()) num.push_back(0);
+    static void set_ntt_threshold(size_t limbs) { NTT_THRESHOLD = limbs; }
+    static size_t ntt_threshold() { return NTT_THRESHOLD; }
+    // Below this many limbs multiplication is schoolbook; at least 4 so the split always shrinks the operands
+    static void set_karatsuba_threshold(size_t limbs) { KARATSUBA_THRESHOLD = std::max<size_t>(limbs, 4); }
+    static size_t karatsuba_threshold() { return KARATSUBA_THRESHOLD; }
+
+    // upper bound on the characters to_chars() writes for this value (sign included)
+    size_t max_chars() const { return num.size() * LIMB_DIGITS + 1; }
+
+    /*
+        Writes the decimal form of the value into [first, last) without any allocation.
+        Mirrors std::to_chars: on success ptr is one past the last written character,
+        if the buffer is too small ec is std::errc::value_too_large and ptr == last.
+    */
+    std::to_chars_result to_chars(char* first, char* last) const {
+        size_t top = count_digits(num.back());
+        size_t len = (_sign ? 0 : 1) + top + (num.size() - 1) * LIMB_DIGITS;
+        if (size_t(last - first) < len) return {last, std::errc::value_too_large};
+        char* out = first;
+        if (!_sign) *out++ = '-';
+        out += top;
+        write_digits(out, num.back(), top);
+        for (int32_t i = int32_t(num.size()) - 2; i >= 0; --i) {
+            out += LIMB_DIGITS;
+            write_digits(out, num[i], LIMB_DIGITS);
+        }
+        return {out, std::errc()};
     }
+
+    /*
+        Parses an optional '-' followed by decimal digits from [first, last) into value,
+        reusing its limb storage. Mirrors std::from_chars: parsing stops at the first
+        non-digit, and ec is std::errc::invalid_argument if no digits were found.
+    */
+    static std::from_chars_result from_chars(const char* first, const char* last, BigInt& value) {
+        const char* p = first;
+        bool negative = (p != last && *p == '-');
+        if (negative) ++p;
+        const char* digits = p;
+        while (p != last && *p >= '0' && *p <= '9') ++p;
+        if (p == digits) return {first, std::errc::invalid_argument};
+        size_t len = size_t(p - digits);
+        value.num.resize((len + LIMB_DIGITS - 1) / LIMB_DIGITS);
+        const char* end = p;
+        for (size_t i = 0; i < value.num.size(); ++i) {
+            const char* begin = (size_t(end - digits) > LIMB_DIGITS) ? end - LIMB_DIGITS : digits;
+            value.num[i] = parse_digits(begin, end);
+            end = begin;
+        }
+        value._sign = !negative;
+        value.normalize();
+        return {p, std::errc()};
+    }
+
+    BigInt(): num{0}, _sign(true) {}
+    BigInt(int64_t x): num(), _sign(true) { assign_small(x); }
     BigInt(const std::string& s) {
         if (!valid_string(s)) throw std::runtime_error("Invalid number string");
-        size_t pos = (s[0] == '-') ? 1 : 0;
-        _sign = (s[0] != '-');
-        for (int32_t i = int32_t(s.size()) - 1; i >= int32_t(pos); i -= 18) {
-            int32_t l = std::max(int32_t(pos), i - 17);
-            int64_t part = 0;
-            for (int32_t j = l; j <= i; ++j) part = part * 10 + (s[j] - '0');
-            num.push_back(part);
-        }
-        normalize();
+        from_chars(s.data(), s.data() + s.size(), *this);
     }
     template <size_t N>
     BigInt(const char (&cstr)[N]): BigInt(std::string(cstr)) {}
     BigInt(const BigInt& o) = default;
+    BigInt(BigInt&& o) noexcept = default;
     BigInt& operator=(const BigInt& o) = default;
-    BigInt& operator=(int64_t x) { return *this = BigInt(x); }
+    BigInt& operator=(BigInt&& o) noexcept = default;
+    BigInt& operator=(int64_t x) { assign_small(x); return *this; }
     BigInt& operator=(const std::string& s) { return *this = BigInt(s); }
     template <size_t N>
     BigInt& operator=(const char (&cstr)[N]) { return *this = std::string(cstr); }
 
     BigInt& operator+=(const BigInt& o) {
-        bool resultSign;
         if (_sign == o._sign) {
             addAbsolute(o);
-            resultSign = _sign;
+        } else if (!less_abs(*this, o)) {
+            subAbsolute(o);
         } else {
-            if (abs() >= o.abs()) {
-                subAbsolute(o);
-                resultSign = _sign;
-            } else {
-                BigInt tmp = o;
-                tmp.subAbsolute(*this);
-                *this = std::move(tmp);
-                resultSign = o._sign;
-            }
+            rsubAbsolute(o);
+            _sign = o._sign;
         }
-        _sign = resultSign;
         normalize();
         return *this;
     }
     BigInt& operator-=(const BigInt& o) {
-        bool resultSign;
         if (_sign != o._sign) {
             addAbsolute(o);
-            resultSign = _sign;
+        } else if (!less_abs(*this, o)) {
+            subAbsolute(o);
         } else {
-            if (abs() >= o.abs()) {
-                subAbsolute(o);
-                resultSign = _sign;
-            } else {
-                BigInt tmp = o;
-                tmp.subAbsolute(*this);
-                *this = std::move(tmp);
-                resultSign = !_sign;
-            }
+            rsubAbsolute(o);
+            _sign = !o._sign;
         }
-        _sign = resultSign;
         normalize();
         return *this;
     }
-    BigInt& operator*=(const BigInt& o) { *this = karatsuba(*this, o); normalize(); return *this; }
+    BigInt& operator*=(const BigInt& o) {
+        if (o.num.size() == 1) {
+            mulSmallAbsolute(o.num[0]);
+            _sign = (_sign == o._sign);
+            normalize();
+            return *this;
+        }
+        *this = karatsuba(*this, o); normalize(); return *this;
+    }
     BigInt& operator/=(const BigInt& o) {
         if (o.is_zero()) throw std::runtime_error("Division by zero");
         bool signRes = (_sign == o._sign);
-        BigInt a = abs(), b = o.abs();
-        if (a < b) { *this = BigInt(0); _sign = true; return *this; }
-        BigInt q(0), r(0);
-        for (int32_t i = int32_t(a.num.size()) - 1; i >= 0; --i) {
-            r.num.insert(r.num.begin(), a.num[i]); r.normalize();
-            int64_t low = 0, high = base - 1;
-            while (low <= high) {
-                int64_t mid = (low + high) >> 1;
-                BigInt t = b * mid;
-                if (t <= r) low = mid + 1;
-                else high = mid - 1;
-            }
-            q.num.insert(q.num.begin(), high);
-            r -= b * high;
-        }
-        q._sign = signRes; q.normalize(); *this = q;
+        BigInt q, r;
+        divmod_abs(*this, o, q, r);
+        q._sign = signRes; q.normalize(); *this = std::move(q);
         return *this;
     }
     BigInt& operator%=(const BigInt& o) {
         if (o.is_zero()) throw std::runtime_error("Modulo by zero");
-        BigInt d = *this / o; *this -= d * o; normalize(); return *this;
+        bool signRes = _sign;
+        BigInt q, r;
+        divmod_abs(*this, o, q, r);
+        r._sign = signRes; r.normalize(); *this = std::move(r);
+        return *this;
     }
 
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    BigInt& operator+=(T x) { return *this += BigInt(int64_t(x)); }
+    BigInt& operator+=(T x) { return add_small(int64_t(x)); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    BigInt& operator-=(T x) { return *this -= BigInt(int64_t(x)); }
+    BigInt& operator-=(T x) { return fits_limb(int64_t(x)) ? add_small(-int64_t(x)) : *this -= BigInt(int64_t(x)); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    BigInt& operator*=(T x) { return *this *= BigInt(int64_t(x)); }
+    BigInt& operator*=(T x) { return mul_small(int64_t(x)); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    BigInt& operator/=(T x) { return *this /= BigInt(int64_t(x)); }
+    BigInt& operator/=(T x) { return div_small(int64_t(x)); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    BigInt& operator%=(T x) { return *this %= BigInt(int64_t(x)); }
+    BigInt& operator%=(T x) { return mod_small(int64_t(x)); }
+
+    friend BigInt operator+(BigInt a, const BigInt& b) { return std::move(a += b); }
+    friend BigInt operator-(BigInt a, const BigInt& b) { return std::move(a -= b); }
+    friend BigInt operator*(BigInt a, const BigInt& b) { return std::move(a *= b); }
+    friend BigInt operator/(BigInt a, const BigInt& b) { return std::move(a /= b); }
+    friend BigInt operator%(BigInt a, const BigInt& b) { return std::move(a %= b); }
+    friend BigInt operator+(const BigInt& a, BigInt&& b) { return std::move(b += a); }
+    friend BigInt operator-(const BigInt& a, BigInt&& b) { b -= a; b.negate(); return std::move(b); }
+    friend BigInt operator*(const BigInt& a, BigInt&& b) { return std::move(b *= a); }
+
+    // dst += src * base^offset without materializing the shifted operand
+    static BigInt& add_shifted(BigInt& dst, const BigInt& src, size_t offset) {
+        if (src.is_zero()) return dst;
+        if (&dst == &src || (dst._sign != src._sign && !dst.is_zero())) return dst += dst.shift_left(src, offset);
+        if (dst.is_zero()) dst._sign = src._sign;
+        dst.addAbsolute(src, offset);
+        dst.normalize();
+        return dst;
+    }
 
-    friend BigInt operator+(BigInt a, const BigInt& b) { return a += b; }
-    friend BigInt operator-(BigInt a, const BigInt& b) { return a -= b; }
-    friend BigInt operator*(BigInt a, const BigInt& b) { return a *= b; }
-    friend BigInt operator/(BigInt a, const BigInt& b) { return a /= b; }
-    friend BigInt operator%(BigInt a, const BigInt& b) { return a %= b; }
+    // dst += a * b; schoolbook-sized products are accumulated straight into dst
+    static BigInt& fma(BigInt& dst, const BigInt& a, const BigInt& b) {
+        if (a.is_zero() || b.is_zero()) return dst;
+        bool productSign = (a._sign == b._sign);
+        bool small = std::max(a.num.size(), b.num.size()) < NTT_THRESHOLD || std::min(a.num.size(), b.num.size()) == 1;
+        if (!small || &dst == &a || &dst == &b || (dst._sign != productSign && !dst.is_zero())) return dst += a * b;
+        if (dst.is_zero()) dst._sign = productSign;
+        dst.addProductAbsolute(a, b);
+        dst.normalize();
+        return dst;
+    }
 
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator+(BigInt a, T b) { return a += b; }
+    friend BigInt operator+(BigInt a, T b) { return std::move(a += b); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator-(BigInt a, T b) { return a -= b; }
+    friend BigInt operator-(BigInt a, T b) { return std::move(a -= b); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator*(BigInt a, T b) { return a *= b; }
+    friend BigInt operator*(BigInt a, T b) { return std::move(a *= b); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator/(BigInt a, T b) { return a /= b; }
+    friend BigInt operator/(BigInt a, T b) { return std::move(a /= b); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator%(BigInt a, T b) { return a %= b; }
+    friend BigInt operator%(BigInt a, T b) { return std::move(a %= b); }
 
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator+(T a, BigInt b) { return b += a; }
+    friend BigInt operator+(T a, BigInt b) { return std::move(b += a); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator-(T a, BigInt b) { return BigInt(int64_t(a)) -= b; }
+    friend BigInt operator-(T a, BigInt b) { b -= a; b.negate(); return b; }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator*(T a, BigInt b) { return b *= a; }
+    friend BigInt operator*(T a, BigInt b) { return std::move(b *= a); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator/(T a, BigInt b) { return BigInt(int64_t(a)) /= b; }
+    friend BigInt operator/(T a, BigInt b) { return std::move(BigInt(int64_t(a)) /= b); }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator%(T a, BigInt b) { return BigInt(int64_t(a)) %= b; }
+    friend BigInt operator%(T a, BigInt b) { return std::move(BigInt(int64_t(a)) %= b); }
 
     BigInt& operator&=(const BigInt& o) {
         size_t n = std::min(num.size(), o.num.size());
@@ -284,9 +791,9 @@ public:
         for (size_t i = 0; i < o.num.size(); ++i) num[i] ^= o.num[i];
         normalize(); return *this;
     }
-    friend BigInt operator&(BigInt a, const BigInt& b) { return a &= b; }
-    friend BigInt operator|(BigInt a, const BigInt& b) { return a |= b; }
-    friend BigInt operator^(BigInt a, const BigInt& b) { return a ^= b; }
+    friend BigInt operator&(BigInt a, const BigInt& b) { return std::move(a &= b); }
+    friend BigInt operator|(BigInt a, const BigInt& b) { return std::move(a |= b); }
+    friend BigInt operator^(BigInt a, const BigInt& b) { return std::move(a ^= b); }
 
     friend BigInt operator<<(BigInt v, int32_t s) {
         if (s < 0) return v >> -s;
@@ -301,12 +808,7 @@ public:
 
     bool operator<(const BigInt& o) const {
         if (_sign != o._sign) return !_sign;
-        if (!_sign) return abs() > o.abs();
-        if (num.size() != o.num.size()) return num.size() < o.num.size();
-        for (int32_t i = int32_t(num.size()) - 1; i >= 0; --i) {
-            if (num[i] != o.num[i]) return num[i] < o.num[i];
-        }
-        return false;
+        return _sign ? less_abs(*this, o) : less_abs(o, *this);
     }
     bool operator>(const BigInt& o) const { return o < *this; }
     bool operator<=(const BigInt& o) const { return !(*this > o); }
@@ -314,10 +816,15 @@ public:
     bool operator==(const BigInt& o) const { return _sign == o._sign && num == o.num; }
     bool operator!=(const BigInt& o) const { return !(*this == o); }
 
-    friend std::ostream& operator<<(std::ostream& os, const BigInt& v) { return os << v.to_string(); }
+    friend std::ostream& operator<<(std::ostream& os, const BigInt& v) {
+        char buf[64];
+        if (v.num.size() * LIMB_DIGITS + 1 <= sizeof(buf)) return os << std::string_view(buf, size_t(v.to_chars(buf, buf + sizeof(buf)).ptr - buf));
+        return os << v.to_string();
+    }
     friend std::istream& operator>>(std::istream& is, BigInt& v) { std::string s; is >> s; v = BigInt(s); return is; }
 
-    BigInt abs() const { BigInt r = *this; r._sign = true; return r; }
+    BigInt abs() const& { BigInt r = *this; r._sign = true; return r; }
+    BigInt abs() && { _sign = true; return std::move(*this); }
     operator std::string() const { return to_string(); }
     explicit operator int64_t() const { return std::stoll(to_string()); }
 
@@ -326,11 +833,11 @@ public:
     BigInt& operator*=(const std::string& s) { return *this *= BigInt(s); }
     BigInt& operator/=(const std::string& s) { return *this /= BigInt(s); }
     BigInt& operator%=(const std::string& s) { return *this %= BigInt(s); }
-    friend BigInt operator+(BigInt a, const std::string& s) { return a += s; }
-    friend BigInt operator-(BigInt a, const std::string& s) { return a -= s; }
-    friend BigInt operator*(BigInt a, const std::string& s) { return a *= s; }
-    friend BigInt operator/(BigInt a, const std::string& s) { return a /= s; }
-    friend BigInt operator%(BigInt a, const std::string& s) { return a %= s; }
+    friend BigInt operator+(BigInt a, const std::string& s) { return std::move(a += s); }
+    friend BigInt operator-(BigInt a, const std::string& s) { return std::move(a -= s); }
+    friend BigInt operator*(BigInt a, const std::string& s) { return std::move(a *= s); }
+    friend BigInt operator/(BigInt a, const std::string& s) { return std::move(a /= s); }
+    friend BigInt operator%(BigInt a, const std::string& s) { return std::move(a %= s); }
     template <size_t N>
     BigInt& operator+=(const char (&s)[N]) { return *this += std::string(s); }
     template <size_t N>
@@ -342,21 +849,22 @@ public:
     template <size_t N>
     BigInt& operator%=(const char (&s)[N]) { return *this %= std::string(s); }
     template <size_t N>
-    friend BigInt operator+(BigInt a, const char (&s)[N]) { return a += s; }
+    friend BigInt operator+(BigInt a, const char (&s)[N]) { return std::move(a += s); }
     template <size_t N>
-    friend BigInt operator-(BigInt a, const char (&s)[N]) { return a -= s; }
+    friend BigInt operator-(BigInt a, const char (&s)[N]) { return std::move(a -= s); }
     template <size_t N>
-    friend BigInt operator*(BigInt a, const char (&s)[N]) { return a *= s; }
+    friend BigInt operator*(BigInt a, const char (&s)[N]) { return std::move(a *= s); }
     template <size_t N>
-    friend BigInt operator/(BigInt a, const char (&s)[N]) { return a /= s; }
+    friend BigInt operator/(BigInt a, const char (&s)[N]) { return std::move(a /= s); }
     template <size_t N>
-    friend BigInt operator%(BigInt a, const char (&s)[N]) { return a %= s; }
+    friend BigInt operator%(BigInt a, const char (&s)[N]) { return std::move(a %= s); }
 
-    BigInt operator-() const {
+    BigInt operator-() const& {
         BigInt r = *this;
-        if (!r.is_zero()) r._sign = !r._sign;
+        r.negate();
         return r;
     }
+    BigInt operator-() && { negate(); return std::move(*this); }
 
     BigInt& operator++() { return *this += 1; }
     BigInt operator++(int32_t) { BigInt tmp = *this; ++*this; return tmp; }
@@ -370,11 +878,11 @@ public:
     template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
     BigInt& operator^=(T x) { return *this ^= BigInt(int64_t(x)); }
     template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator&(BigInt a, T b) { return a &= b; }
+    friend BigInt operator&(BigInt a, T b) { return std::move(a &= b); }
     template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator|(BigInt a, T b) { return a |= b; }
+    friend BigInt operator|(BigInt a, T b) { return std::move(a |= b); }
     template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend BigInt operator^(BigInt a, T b) { return a ^= b; }
+    friend BigInt operator^(BigInt a, T b) { return std::move(a ^= b); }
 
     friend BigInt operator<<(BigInt v, int64_t s) {
         if (s < 0) return v >> -s;
@@ -4,8 +4,10 @@ It is not a common or well-known one.
 
 IndexedList is a data structure designed to maintain a list of elements with efficient 
 indexed access, insertion, and removal operations. It internally uses a linked list of blocks, 
-where each block contains a linked list of nodes, allowing the structure to balance itself 
-and maintain roughly O(sqrt(N)) complexity for insertions, removals, and indexed accesses.
+where each block keeps its elements in one contiguous array, so finding an element inside a
+block is O(1) and inserting into it is a memmove. After every change only the touched block
+and its neighbours are split or merged, which keeps roughly O(sqrt(N)) blocks of O(sqrt(N))
+elements and O(sqrt(N)) complexity for insertions, removals, and indexed accesses.
 
 - get(index): O(sqrt(N))
 - set(index, value): O(sqrt(N))
@@ -16,6 +18,7 @@ and maintain roughly O(sqrt(N)) complexity for insertions, removals, and indexed
 
 This makes IndexedList suitable for scenarios where frequent insertions/removals occur 
 at arbitrary positions and fast indexed access is required, better than a simple linked list.
+For very large lists, BTreeIndexedList (below) offers the same API in O(log(N)).
 
 @fortesting
 https://algoleague.com/problem/indexing-problem/detail
@@ -25,6 +28,8 @@ https://algoleague.com/problem/indexing-problem/detail
 #include <string>
 #include <cmath>
 #include <cassert>
+#include <algorithm>
+#include "instrumentation.h"
 
 template<typename T>
 class IndexedList{
@@ -37,206 +42,120 @@ private:
         std:: string _text;
     };
 
-    class ILNode{
+    // Elements of a block live in one contiguous array, items[0 .. size).
+    class ILBlock{
     public:
-        T data;
-        ILNode *prev, *next;
-        ILNode(){
-            data = 0;
+        ILBlock(size_t capacity){
+            this->capacity = capacity < 4 ? 4 : capacity;
+            items = new T[this->capacity];
+            size = 0;
             prev = NULL;
             next = NULL;
         }
-        ILNode(T data){
-            this->data = data;
-            prev = NULL;
-            next = NULL;
+        ~ILBlock(){
+            delete[] items;
         }
-        ILNode(T data, ILNode *prev, ILNode *next){
-            this->data = data;
-            this->prev = prev;
-            this->next = next;
+        // makes room for at least need elements, keeping the current ones
+        void reserve(size_t need){
+            if(need <= capacity) return;
+            size_t new_capacity = capacity * 2 < need ? need : capacity * 2;
+            T *grown = new T[new_capacity];
+            INSTRUMENT_COUNT("indexed_list.allocations");
+            std::move(items, items + size, grown);
+            delete[] items;
+            items = grown;
+            capacity = new_capacity;
         }
-    };
-
-    class ILBlock{
-    public:
-        ILBlock(){
-            size = 0;
-            prev = NULL;
-            next = NULL;
-            head = NULL;
-        }
-        void clear(){
-            ILNode *temp;
-            while(head!=NULL){
-                temp = head->next;
-                delete head;
-                head = temp;
-            }
+        void insert(size_t pos, const T& data){
+            reserve(size + 1);
+            std::move_backward(items + pos, items + size, items + size + 1);
+            items[pos] = data;
+            size ++;
+        }
+        void erase(size_t pos){
+            std::move(items + pos + 1, items + size, items + pos);
+            size --;
         }
         ILBlock *prev, *next;
-        ILNode *head;
-        size_t size;
+        T *items;
+        size_t size, capacity;
     };
     
 public:
     IndexedList(){
         total_size = 0;
-        head = new ILBlock;
+        head = new ILBlock(4);
     }
     
     ~IndexedList(){
         ILBlock *block = head, *temp;
         while(block != NULL){
             temp = block->next;
-            block->clear();
             delete block;
             block = temp;
         }
     }
+
+    IndexedList(const IndexedList&) = delete;
+    IndexedList& operator=(const IndexedList&) = delete;
     
     // Returns the element at the specified index.
     // Throws an exception if index is out of bounds.
     T get(size_t index){
-        if(index > total_size or index < 0){
+        if(index >= total_size){
             throw ILException("get error: List index out of range");
         }
-        if(index == 0){
-            return head->head->data;
-        }
-        else{
-            size_t cur = 0;
-            ILBlock *block = head;
-            while(cur + block->size - 1 < index){
-                cur += block->size;
-                block = block->next;
-            }
-            ILNode *node = block->head;
-            while(cur < index){
-                node = node -> next;
-                cur++;
-            }
-            return node->data;
-        }
+        ILBlock *block = find_block(index);
+        return block->items[index];
     }
     
     // Sets the element at the specified index to the given data.
     // Throws an exception if index is out of bounds.
     void set(size_t index, T data){
-        if(index > total_size or index < 0){
+        if(index >= total_size){
             throw ILException("set error: List index out of range");
         }
-        if(index == 0){
-            head->head->data = data;
-            return;
-        }
-        else{
-            size_t cur = 0;
-            ILBlock *block = head;
-            while(cur + block->size - 1 < index){
-                cur += block->size;
-                block = block->next;
-            }
-            ILNode *node = block->head;
-            while(cur < index){
-                node = node -> next;
-                cur++;
-            }
-            node->data = data;
-            return;
-        }
+        ILBlock *block = find_block(index);
+        block->items[index] = data;
     }
     
     // Inserts a new element with the given data at the specified index.
     // Throws an exception if index is out of bounds.
     void insert(size_t index, T data){
-        if(index > total_size or index < 0){
+        if(index > total_size){
             throw ILException("insert error: List index out of range");
         }
-        size_t cur = 0;
         ILBlock *block = head;
-        if(index == 0){
-            block->head = new ILNode(data,NULL,block->head);
-        }
-        else{
-            while(cur + block->size < index){
-                cur += block->size;
-                block = block->next;
-            }
-            ILNode *node = block->head;
-            while(cur < index-1){
-                node = node -> next;
-                cur++;
-            }
-            node->next = new ILNode(data, node, node->next);
-            node = node->next;
-            if(node->next) node->next->prev = node;
+        while(index > block->size and block->next != NULL){
+            index -= block->size;
+            block = block->next;
         }
-        block->size ++;
+        block->insert(index, data);
         total_size ++;
-        balance();
+        balance(block);
     }
     
     // Removes the element at the specified index.
     // Throws an exception if index is out of bounds.
     void remove(size_t index){
-        if(index > total_size or index < 0){
+        if(index >= total_size){
             throw ILException("remove error: List index out of range");
         }
-        
-        if(index == 0){
-            ILNode *node = head->head->next;
-            delete head->head;
-            head->head = node;
-            if(node) node->prev = NULL;
-            head->size --;
-        }
-        else{
-            size_t cur = 0;
-            ILBlock *block = head;
-            while(cur + block->size - 1 < index){
-                cur += block->size;
-                block = block->next;
-            }
-            if(cur == index){
-                ILNode *node = block->head->next;
-                delete block->head;
-                block->head = node;
-                if(node)node->prev = NULL;
-                block->size --;
-            }
-            else{
-                ILNode *node = block->head;
-                while(cur < index){
-                    node = node -> next;
-                    cur++;
-                }
-                if(node->prev){
-                    node->prev->next = node->next;
-                }
-                if(node->next){
-                    node->next->prev = node->prev;
-                }
-                delete node;
-                block->size --;
-            }
-        }
+        ILBlock *block = find_block(index);
+        block->erase(index);
         total_size--;
-        balance();
+        balance(block);
     }
     
     // Prints all elements in the list.
     // If split is true, prints blocks separately with block info.
     void printall(bool split = false){
         ILBlock *block = head;
-        ILNode *node;
         size_t block_num = 0;
         while(block != NULL){
-            node = block->head;
             if(split) std :: cout << block_num << " ("<< block->size << ") -> ";
-            while(node != NULL){
-                std :: cout << node->data << " ";
-                node = node->next;
+            for(size_t i=0;i<block->size;i++){
+                std :: cout << block->items[i] << " ";
             }
             if(split) std :: cout << '\n';
             block = block->next;
@@ -253,63 +172,397 @@ public:
 private:
     size_t total_size;
     ILBlock *head;
-    
-    void balance(){
+
+    // Returns the block holding index and turns index into the position inside it.
+    ILBlock* find_block(size_t& index){
+        ILBlock *block = head;
+        while(index >= block->size){
+            index -= block->size;
+            block = block->next;
+        }
+        return block;
+    }
+
+    void unlink(ILBlock *block){
+        if(block->prev) block->prev->next = block->next;
+        else head = block->next;
+        if(block->next) block->next->prev = block->prev;
+        delete block;
+    }
+
+    // Appends the elements of block->next to block and drops block->next.
+    void merge_next(ILBlock *block){
+        INSTRUMENT_COUNT("indexed_list.merges");
+        ILBlock *other = block->next;
+        block->reserve(block->size + other->size);
+        std::move(other->items, other->items + other->size, block->items + block->size);
+        block->size += other->size;
+        unlink(other);
+    }
+
+    // Only the block that just changed and its neighbours are looked at:
+    // split it when it reaches 2*sqrt(N), merge it with a neighbour when both together stay below sqrt(N).
+    void balance(ILBlock *block){
         size_t tresh = sqrt(total_size);
         if(tresh < 2) tresh = 2;
-        while(head != NULL and head->size == 0){
-            ILBlock *temp = head->next;
-            delete head;
-            head = temp;
+        if(block->size >= 2*tresh){
+            INSTRUMENT_COUNT("indexed_list.splits");
+            size_t keep = block->size / 2;
+            // a block filled while N was larger can hold more than 2*tresh after N shrinks
+            ILBlock *new_block = new ILBlock(std::max(2*tresh, block->size - keep));
+            std::move(block->items + keep, block->items + block->size, new_block->items);
+            new_block->size = block->size - keep;
+            block->size = keep;
+            new_block->prev = block;
+            new_block->next = block->next;
+            if(new_block->next) new_block->next->prev = new_block;
+            block->next = new_block;
+        }
+        else if(block->size == 0 and (block->prev or block->next)){
+            unlink(block);
+        }
+        else if(block->next and block->size + block->next->size < tresh){
+            merge_next(block);
+        }
+        else if(block->prev and block->prev->size + block->size < tresh){
+            merge_next(block->prev);
+        }
+    }
+};
+
+/*
+BTreeIndexedList is an alternate backend for IndexedList with the same API.
+
+It is a B+ tree used as a rope: leaves keep elements in contiguous arrays, inner nodes keep
+child pointers next to the element count of every child subtree. An index is found by walking
+down and subtracting subtree sizes, inserts and removes touch one leaf (a memmove) and split,
+merge or redistribute only nodes on that root-to-leaf path.
+
+- get(index): O(log(N))
+- set(index, value): O(log(N))
+- insert(index, value): O(log(N))
+- remove(index): O(log(N))
+- printall(): O(N)
+- size(): O(1)
+
+Leaves hold up to 64 elements and inner nodes up to 32 children, so at 10M elements the tree
+has 4-5 levels and each level is one or two cache lines of sizes to scan.
+T must be default constructible and assignable.
+*/
+
+template<typename T>
+class BTreeIndexedList{
+private:
+    class ILException{
+    public:
+        ILException(std:: string exception = "") : _text(exception)   {
+        std :: cout << _text << std :: endl;
+        }
+        std:: string _text;
+    };
+
+    static const size_t LEAF_CAP = 64;
+    static const size_t FANOUT = 32;
+
+    class BNode{
+    public:
+        bool leaf;
+        size_t count;   // elements in a leaf, children in an inner node
+        BNode(bool leaf) : leaf(leaf), count(0) {}
+    };
+    class BLeaf : public BNode{
+    public:
+        T items[LEAF_CAP];
+        BLeaf() : BNode(true) {}
+    };
+    class BInner : public BNode{
+    public:
+        BNode *child[FANOUT];
+        size_t sizes[FANOUT];
+        BInner() : BNode(false) {}
+    };
+
+public:
+    BTreeIndexedList(){
+        total_size = 0;
+        root = new BLeaf;
+    }
+
+    ~BTreeIndexedList(){
+        destroy(root);
+    }
+
+    BTreeIndexedList(const BTreeIndexedList&) = delete;
+    BTreeIndexedList& operator=(const BTreeIndexedList&) = delete;
+
+    // Returns the element at the specified index.
+    // Throws an exception if index is out of bounds.
+    T get(size_t index){
+        if(index >= total_size){
+            throw ILException("get error: List index out of range");
         }
-        if(head == NULL){
-            head = new ILBlock;
+        return locate(index);
+    }
+
+    // Sets the element at the specified index to the given data.
+    // Throws an exception if index is out of bounds.
+    void set(size_t index, T data){
+        if(index >= total_size){
+            throw ILException("set error: List index out of range");
+        }
+        locate(index) = data;
+    }
+
+    // Inserts a new element with the given data at the specified index.
+    // Throws an exception if index is out of bounds.
+    void insert(size_t index, T data){
+        if(index > total_size){
+            throw ILException("insert error: List index out of range");
+        }
+        BNode *split = insert_into(root, index, data);
+        if(split){
+            BInner *new_root = new BInner;
+            new_root->child[0] = root;
+            new_root->sizes[0] = node_size(root);
+            new_root->child[1] = split;
+            new_root->sizes[1] = node_size(split);
+            new_root->count = 2;
+            root = new_root;
+        }
+        total_size ++;
+    }
+
+    // Removes the element at the specified index.
+    // Throws an exception if index is out of bounds.
+    void remove(size_t index){
+        if(index >= total_size){
+            throw ILException("remove error: List index out of range");
+        }
+        remove_from(root, index);
+        while(!root->leaf and root->count == 1){
+            BNode *only = static_cast<BInner*>(root)->child[0];
+            delete static_cast<BInner*>(root);
+            root = only;
+        }
+        total_size--;
+    }
+
+    // Prints all elements in the list.
+    // If split is true, prints leaves separately with leaf info.
+    void printall(bool split = false){
+        size_t leaf_num = 0;
+        print_node(root, split, leaf_num);
+        if(!split) std :: cout << '\n';
+    }
+
+    // Returns the current total number of elements in the list.
+    size_t size(){
+        return total_size;
+    }
+
+private:
+    size_t total_size;
+    BNode *root;
+
+    static size_t capacity(const BNode *node){
+        return node->leaf ? LEAF_CAP : FANOUT;
+    }
+
+    static size_t node_size(const BNode *node){
+        if(node->leaf) return node->count;
+        const BInner *inner = static_cast<const BInner*>(node);
+        size_t sum = 0;
+        for(size_t i=0;i<inner->count;i++) sum += inner->sizes[i];
+        return sum;
+    }
+
+    static void destroy(BNode *node){
+        if(node->leaf){
+            delete static_cast<BLeaf*>(node);
             return;
         }
-        ILBlock *block = head;
-        head -> prev = NULL;
-        while(block != NULL){
-            if(block->size >= 2*tresh){
-                ILNode *node = block->head;
-                size_t cur = 1;
-                while(cur<tresh){
-                    node = node->next;
-                    cur ++;
+        BInner *inner = static_cast<BInner*>(node);
+        for(size_t i=0;i<inner->count;i++) destroy(inner->child[i]);
+        delete inner;
+    }
+
+    T& locate(size_t index){
+        BNode *node = root;
+        while(!node->leaf){
+            BInner *inner = static_cast<BInner*>(node);
+            size_t k = 0;
+            while(index >= inner->sizes[k]){
+                index -= inner->sizes[k];
+                k++;
+            }
+            node = inner->child[k];
+        }
+        return static_cast<BLeaf*>(node)->items[index];
+    }
+
+    // Moves the upper half of a full node into a new right sibling and returns it.
+    static BNode* split_half(BNode *node){
+        INSTRUMENT_COUNT("btree_list.splits");
+        size_t keep = node->count / 2;
+        if(node->leaf){
+            BLeaf *leaf = static_cast<BLeaf*>(node), *right = new BLeaf;
+            std::move(leaf->items + keep, leaf->items + leaf->count, right->items);
+            right->count = leaf->count - keep;
+            leaf->count = keep;
+            return right;
+        }
+        BInner *inner = static_cast<BInner*>(node), *right = new BInner;
+        std::copy(inner->child + keep, inner->child + inner->count, right->child);
+        std::copy(inner->sizes + keep, inner->sizes + inner->count, right->sizes);
+        right->count = inner->count - keep;
+        inner->count = keep;
+        return right;
+    }
+
+    // Inserts into the subtree of node, returns the new right sibling if node had to split.
+    BNode* insert_into(BNode *node, size_t index, const T& data){
+        if(node->leaf){
+            BLeaf *leaf = static_cast<BLeaf*>(node), *right = NULL;
+            if(leaf->count == LEAF_CAP){
+                right = static_cast<BLeaf*>(split_half(leaf));
+                if(index > leaf->count){
+                    index -= leaf->count;
+                    leaf = right;
                 }
-                node->next->prev = NULL;
-                ILBlock *new_block = new ILBlock;
-                new_block->head = node->next;
-                new_block->size = block->size - tresh;
-                node->next = NULL;
-                new_block->prev = block;
-                new_block->next = block->next;
-                if(new_block->next) new_block->next->prev = new_block;
-                block->next = new_block;
-                block->size = tresh;
-                block = block->next;
             }
-            else if(block->next and block->next->size == 0){
-                ILBlock *temp = block->next->next;
-                delete block->next;
-                block->next = temp;
+            std::move_backward(leaf->items + index, leaf->items + leaf->count, leaf->items + leaf->count + 1);
+            leaf->items[index] = data;
+            leaf->count ++;
+            return right;
+        }
+        BInner *inner = static_cast<BInner*>(node);
+        size_t k = 0;
+        while(k + 1 < inner->count and index > inner->sizes[k]){
+            index -= inner->sizes[k];
+            k++;
+        }
+        BNode *split = insert_into(inner->child[k], index, data);
+        inner->sizes[k] ++;
+        if(!split) return NULL;
+        size_t split_size = node_size(split);
+        inner->sizes[k] -= split_size;
+        BInner *right = NULL, *target = inner;
+        size_t pos = k + 1;
+        if(inner->count == FANOUT){
+            right = static_cast<BInner*>(split_half(inner));
+            if(pos > inner->count){
+                pos -= inner->count;
+                target = right;
+            }
+        }
+        std::copy_backward(target->child + pos, target->child + target->count, target->child + target->count + 1);
+        std::copy_backward(target->sizes + pos, target->sizes + target->count, target->sizes + target->count + 1);
+        target->child[pos] = split;
+        target->sizes[pos] = split_size;
+        target->count ++;
+        return right;
+    }
+
+    void remove_from(BNode *node, size_t index){
+        if(node->leaf){
+            BLeaf *leaf = static_cast<BLeaf*>(node);
+            std::move(leaf->items + index + 1, leaf->items + leaf->count, leaf->items + index);
+            leaf->count --;
+            return;
+        }
+        BInner *inner = static_cast<BInner*>(node);
+        size_t k = 0;
+        while(index >= inner->sizes[k]){
+            index -= inner->sizes[k];
+            k++;
+        }
+        remove_from(inner->child[k], index);
+        inner->sizes[k] --;
+        if(inner->child[k]->count < capacity(inner->child[k]) / 4 and inner->count > 1){
+            fix_underflow(inner, k == 0 ? 0 : k - 1);
+        }
+    }
+
+    // Children l and l+1 of parent: merged if they fit in one node, otherwise split evenly.
+    static void fix_underflow(BInner *parent, size_t l){
+        INSTRUMENT_COUNT("btree_list.rebalances");
+        BNode *a = parent->child[l], *b = parent->child[l + 1];
+        size_t total = a->count + b->count;
+        if(a->leaf){
+            BLeaf *x = static_cast<BLeaf*>(a), *y = static_cast<BLeaf*>(b);
+            if(total <= LEAF_CAP){
+                std::move(y->items, y->items + y->count, x->items + x->count);
+                x->count = total;
+                y->count = 0;
             }
-            else if(block->next and block->size + block->next->size < tresh){
-                block->size += block->next->size;
-                ILNode *node = block->head;
-                ILBlock *del = block->next;
-                while(node->next != NULL){
-                    node = node->next;
+            else{
+                size_t want = total / 2;
+                if(x->count < want){
+                    size_t move = want - x->count;
+                    std::move(y->items, y->items + move, x->items + x->count);
+                    std::move(y->items + move, y->items + y->count, y->items);
+                }
+                else{
+                    size_t move = x->count - want;
+                    std::move_backward(y->items, y->items + y->count, y->items + y->count + move);
+                    std::move(x->items + want, x->items + x->count, y->items);
                 }
-                node->next = del->head;
-                if(node->next) node->next->prev = node;
-                block->next = block->next->next;
-                if(block->next) block->next->prev = block;
-                delete del;
+                x->count = want;
+                y->count = total - want;
+            }
+        }
+        else{
+            BInner *x = static_cast<BInner*>(a), *y = static_cast<BInner*>(b);
+            if(total <= FANOUT){
+                std::copy(y->child, y->child + y->count, x->child + x->count);
+                std::copy(y->sizes, y->sizes + y->count, x->sizes + x->count);
+                x->count = total;
+                y->count = 0;
             }
             else{
-                block = block->next;
+                size_t want = total / 2;
+                if(x->count < want){
+                    size_t move = want - x->count;
+                    std::copy(y->child, y->child + move, x->child + x->count);
+                    std::copy(y->sizes, y->sizes + move, x->sizes + x->count);
+                    std::copy(y->child + move, y->child + y->count, y->child);
+                    std::copy(y->sizes + move, y->sizes + y->count, y->sizes);
+                }
+                else{
+                    size_t move = x->count - want;
+                    std::copy_backward(y->child, y->child + y->count, y->child + y->count + move);
+                    std::copy_backward(y->sizes, y->sizes + y->count, y->sizes + y->count + move);
+                    std::copy(x->child + want, x->child + x->count, y->child);
+                    std::copy(x->sizes + want, x->sizes + x->count, y->sizes);
+                }
+                x->count = want;
+                y->count = total - want;
             }
         }
+        if(b->count == 0){
+            if(b->leaf) delete static_cast<BLeaf*>(b);
+            else delete static_cast<BInner*>(b);
+            std::copy(parent->child + l + 2, parent->child + parent->count, parent->child + l + 1);
+            std::copy(parent->sizes + l + 2, parent->sizes + parent->count, parent->sizes + l + 1);
+            parent->count --;
+            parent->sizes[l] = node_size(a);
+        }
+        else{
+            parent->sizes[l] = node_size(a);
+            parent->sizes[l + 1] = node_size(b);
+        }
     }
-};
 
+    void print_node(BNode *node, bool split, size_t& leaf_num){
+        if(node->leaf){
+            BLeaf *leaf = static_cast<BLeaf*>(node);
+            if(split) std :: cout << leaf_num << " ("<< leaf->count << ") -> ";
+            for(size_t i=0;i<leaf->count;i++) std :: cout << leaf->items[i] << " ";
+            if(split) std :: cout << '\n';
+            leaf_num++;
+            return;
+        }
+        BInner *inner = static_cast<BInner*>(node);
+        for(size_t i=0;i<inner->count;i++) print_node(inner->child[i], split, leaf_num);
+    }
+};
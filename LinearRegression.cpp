@@ -12,6 +12,20 @@ LinearRegression class complexity overview:
 - Training loop (Train): O(steps * N * M)
   steps = number of gradient descent iterations
 
+- Closed form training (Train with "solver" = 1): O(N * M^2 + M^3)
+  builds X^T X and X^T y in one pass over the normalized data and solves them with a Cholesky
+  factorization, "steps" and "lr" are ignored. "l2" adds a ridge penalty on the normalized
+  coefficients, relative to the mean squared error.
+  Columns that are constant or linearly dependent on earlier ones get a zero coefficient.
+
+Training copies the samples into a contiguous row-major double matrix (DataMatrix),
+so the prediction and gradient kernels vectorize.
+
+- Streaming training (TrainStream): O(epochs * N * M) time, O(chunk_rows * M) memory
+  reads chunks from a SampleSource (CsvSource for files, IteratorSource for ranges),
+  one Welford pass gives the means and deviations, then every epoch runs mini-batch SGD.
+  Each batch gradient is split over "threads" workers and summed before the update.
+
 - Denormalization (DenormalizeCoefficients): O(M)
 
 - Prediction (Estimate): O(M)
@@ -28,6 +42,13 @@ Overall complexity is dominated by training: O(steps × N × M), typical for bat
 #include <chrono>
 #include <iomanip>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 std :: ostream& operator<<(std :: ostream& os, const std :: vector<long double>& v){
     std :: cout << "{";
@@ -54,6 +75,310 @@ namespace VectorOperations{
     }
 }
 
+// Samples stored row by row in one buffer, labels kept apart
+struct DataMatrix{
+    int rows = 0, cols = 0;
+    std :: vector<double> x;
+    std :: vector<double> y;
+
+    const double* Row(int i) const {
+        return x.data() + (size_t)i * cols;
+    }
+    double* Row(int i) {
+        return x.data() + (size_t)i * cols;
+    }
+};
+
+namespace MatrixKernels{
+    // Four independent partial sums so the compiler can keep them in vector registers
+    inline double Dot(const double* a, const double* b, int n){
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        int i = 0;
+        for(; i + 4 <= n; i += 4){
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        for(; i < n; i++){
+            s0 += a[i] * b[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // out += alpha * a
+    inline void Axpy(double* out, double alpha, const double* a, int n){
+        for(int i = 0; i < n; i++){
+            out[i] += alpha * a[i];
+        }
+    }
+
+    // coefs[0] is the intercept, the remaining entries line up with the row
+    inline double Predict(const std :: vector<double>& coefs, const double* row, int n){
+        return coefs[0] + Dot(coefs.data() + 1, row, n);
+    }
+
+    // Adds the unscaled gradient of the squared error over rows [from, to) to grad
+    inline void AccumulateGradient(const DataMatrix& m, int from, int to, const std :: vector<double>& coefs, std :: vector<double>& grad){
+        for(int i = from; i < to; i++){
+            const double* row = m.Row(i);
+            double single = Predict(coefs, row, m.cols) - m.y[i];
+            grad[0] += single;
+            Axpy(grad.data() + 1, single, row, m.cols);
+        }
+    }
+
+    // Solves (A + l2 * I) w = b for a symmetric positive semi-definite n x n matrix A, in place.
+    // Pivots that vanish mark a dependent column, its coefficient is set to zero.
+    inline std :: vector<double> CholeskySolve(std :: vector<double> a, std :: vector<double> b, int n, double l2){
+        double scale = 0.0;
+        for(int i = 0; i < n; i++){
+            a[(size_t)i * n + i] += l2;
+            scale = std :: max(scale, a[(size_t)i * n + i]);
+        }
+        const double eps = 1e-12 * std :: max(scale, 1.0);
+        std :: vector<char> dropped(n, 0);
+        for(int j = 0; j < n; j++){
+            double* rj = a.data() + (size_t)j * n;
+            double d = rj[j] - Dot(rj, rj, j);
+            if(d <= eps){
+                dropped[j] = 1;
+                for(int k = 0; k <= j; k++) rj[k] = 0.0;
+                for(int i = j + 1; i < n; i++) a[(size_t)i * n + j] = 0.0;
+                continue;
+            }
+            rj[j] = std :: sqrt(d);
+            for(int i = j + 1; i < n; i++){
+                double* ri = a.data() + (size_t)i * n;
+                ri[j] = (ri[j] - Dot(ri, rj, j)) / rj[j];
+            }
+        }
+        // L z = b, then L^T w = z
+        for(int i = 0; i < n; i++){
+            const double* ri = a.data() + (size_t)i * n;
+            b[i] = dropped[i] ? 0.0 : (b[i] - Dot(ri, b.data(), i)) / ri[i];
+        }
+        for(int i = n - 1; i >= 0; i--){
+            if(dropped[i]){
+                b[i] = 0.0;
+                continue;
+            }
+            double value = b[i];
+            for(int k = i + 1; k < n; k++){
+                value -= a[(size_t)k * n + i] * b[k];
+            }
+            b[i] = value / a[(size_t)i * n + i];
+        }
+        return b;
+    }
+}
+
+// Yields the samples in chunks, the label is the last column. Rewind starts the data over,
+// TrainStream reads it once for the statistics and once per epoch.
+class SampleSource{
+public:
+    virtual ~SampleSource() = default;
+    // Replaces chunk with up to max_rows samples, false once nothing is left
+    virtual bool Next(DataMatrix& chunk, int max_rows) = 0;
+    virtual void Rewind() = 0;
+};
+
+// Text file with one sample per line, values separated by commas or whitespace
+class CsvSource : public SampleSource{
+public:
+    CsvSource(const std :: string& path) : path(path), file(path) {
+        if(!file) throw std :: runtime_error("CsvSource: cannot open " + path);
+    }
+
+    bool Next(DataMatrix& chunk, int max_rows) override {
+        chunk.rows = 0;
+        chunk.x.clear();
+        chunk.y.clear();
+        std :: string line;
+        while(chunk.rows < max_rows and std :: getline(file, line)){
+            values.clear();
+            for(char& c : line){
+                if(c == ',') c = ' ';
+            }
+            std :: istringstream in(line);
+            double v;
+            while(in >> v) values.push_back(v);
+            if(values.empty()) continue;
+            if(cols == -1) cols = (int)values.size() - 1;
+            if((int)values.size() != cols + 1){
+                throw std :: runtime_error("CsvSource: inconsistent column count in " + path);
+            }
+            chunk.x.insert(chunk.x.end(), values.begin(), values.end() - 1);
+            chunk.y.push_back(values.back());
+            chunk.rows++;
+        }
+        chunk.cols = cols;
+        return chunk.rows > 0;
+    }
+
+    void Rewind() override {
+        file.clear();
+        file.seekg(0);
+    }
+
+private:
+    std :: string path;
+    std :: ifstream file;
+    std :: vector<double> values;
+    int cols = -1;
+};
+
+// Any forward range of samples, e.g. a std :: vector<std :: vector<long double> >, read without copying it whole
+template <typename It>
+class IteratorSource : public SampleSource{
+public:
+    IteratorSource(It first, It last) : first(first), last(last), current(first) {}
+
+    bool Next(DataMatrix& chunk, int max_rows) override {
+        chunk.rows = 0;
+        chunk.x.clear();
+        chunk.y.clear();
+        for(; current != last and chunk.rows < max_rows; ++current){
+            const auto& sample = *current;
+            chunk.cols = (int)sample.size() - 1;
+            for(int j=0;j<chunk.cols;j++){
+                chunk.x.push_back((double)sample[j]);
+            }
+            chunk.y.push_back((double)sample[chunk.cols]);
+            chunk.rows++;
+        }
+        return chunk.rows > 0;
+    }
+
+    void Rewind() override {
+        current = first;
+    }
+
+private:
+    It first, last, current;
+};
+
+// Welford's running mean and variance per feature column and for the label
+struct RunningStats{
+    long long count = 0;
+    std :: vector<double> mean, m2;
+    double mean_y = 0.0, m2_y = 0.0;
+
+    void Add(const DataMatrix& chunk){
+        if(mean.empty()){
+            mean.assign(chunk.cols, 0.0);
+            m2.assign(chunk.cols, 0.0);
+        }
+        for(int i=0;i<chunk.rows;i++){
+            count++;
+            double inv = 1.0 / count;
+            const double* row = chunk.Row(i);
+            for(int j=0;j<chunk.cols;j++){
+                double delta = row[j] - mean[j];
+                mean[j] += delta * inv;
+                m2[j] += delta * (row[j] - mean[j]);
+            }
+            double delta = chunk.y[i] - mean_y;
+            mean_y += delta * inv;
+            m2_y += delta * (chunk.y[i] - mean_y);
+        }
+    }
+
+    double StdDev(int j) const {
+        return count ? std :: sqrt(m2[j] / count) : 0.0;
+    }
+    double StdDevY() const {
+        return count ? std :: sqrt(m2_y / count) : 0.0;
+    }
+};
+
+// Fixed set of threads that compute one batch gradient together. Worker t sums rows of its
+// share into its own buffer, Run sums the buffers once everyone is done.
+class GradientWorkers{
+public:
+    GradientWorkers(int threads) : threads(std :: max(threads, 1)) {
+        for(int t=1;t<this->threads;t++){
+            pool.emplace_back([this, t]{ Loop(t); });
+        }
+    }
+
+    ~GradientWorkers() {
+        {
+            std :: lock_guard<std :: mutex> lock(mutex);
+            stop = true;
+            generation++;
+        }
+        wake.notify_all();
+        for(std :: thread& th : pool) th.join();
+    }
+
+    GradientWorkers(const GradientWorkers&) = delete;
+    GradientWorkers& operator=(const GradientWorkers&) = delete;
+
+    // grad = sum of the squared error gradients over rows [from, to) of m
+    void Run(const DataMatrix& m, int from, int to, const std :: vector<double>& coefs, std :: vector<double>& grad){
+        partial.resize(threads);
+        for(std :: vector<double>& p : partial) p.assign(coefs.size(), 0.0);
+        job_matrix = &m;
+        job_coefs = &coefs;
+        job_from = from;
+        job_to = to;
+        if(threads > 1){
+            {
+                std :: lock_guard<std :: mutex> lock(mutex);
+                pending = threads - 1;
+                generation++;
+            }
+            wake.notify_all();
+        }
+        Work(0);
+        if(threads > 1){
+            std :: unique_lock<std :: mutex> lock(mutex);
+            done.wait(lock, [this]{ return pending == 0; });
+        }
+        grad.assign(coefs.size(), 0.0);
+        for(const std :: vector<double>& p : partial){
+            MatrixKernels :: Axpy(grad.data(), 1.0, p.data(), (int)grad.size());
+        }
+    }
+
+private:
+    int threads;
+    std :: vector<std :: thread> pool;
+    std :: mutex mutex;
+    std :: condition_variable wake, done;
+    long long generation = 0;
+    int pending = 0;
+    bool stop = false;
+
+    const DataMatrix* job_matrix = nullptr;
+    const std :: vector<double>* job_coefs = nullptr;
+    int job_from = 0, job_to = 0;
+    std :: vector<std :: vector<double> > partial;
+
+    void Work(int t){
+        long long len = job_to - job_from;
+        int from = job_from + (int)(len * t / threads);
+        int to = job_from + (int)(len * (t + 1) / threads);
+        MatrixKernels :: AccumulateGradient(*job_matrix, from, to, *job_coefs, partial[t]);
+    }
+
+    void Loop(int t){
+        long long seen = 0;
+        while(true){
+            {
+                std :: unique_lock<std :: mutex> lock(mutex);
+                wake.wait(lock, [&]{ return generation != seen; });
+                seen = generation;
+                if(stop) return;
+            }
+            Work(t);
+            std :: lock_guard<std :: mutex> lock(mutex);
+            if(--pending == 0) done.notify_one();
+        }
+    }
+};
+
 class LinearRegression{
 public:
     void Train(std :: vector <std :: vector<long double> > data, std :: map<std :: string, long double>parameters = {}) {
@@ -62,6 +387,8 @@ public:
         params["steps"] = 1000;
         params["shuffle"] = 1.0;
         params["split_rate"] = 80.0;
+        params["solver"] = 0.0;
+        params["l2"] = 0.0;
         
         for(auto p : parameters){
             params[p.first] = p.second;
@@ -71,41 +398,218 @@ public:
         int steps = (int)(params["steps"]);
         bool will_be_shuffled = (params["shuffle"] == 0.0);
         long double split_rate = params["split_rate"];
+        bool closed_form = (params["solver"] == 1.0);
         
         int i, j;
         
         if(will_be_shuffled) VectorOperations :: Shuffle(data);
         
-        std :: vector<long double> results;
-        for(i=0;i<data.size();i++){
-            results.push_back(data[i].back());
-            data[i].pop_back();
-        }
+        DataMatrix matrix = ToMatrix(data);
+        data.clear();
+        data.shrink_to_fit();
         
         std :: vector<long double> means, std_devs;
         long double mean_y = 0.0, std_dev_y = 0.0;
-        NormalizeData(data, results, means, std_devs, mean_y, std_dev_y);
+        NormalizeMatrix(matrix, means, std_devs, mean_y, std_dev_y);
         
-        int n = data[0].size();
-        std :: vector<long double> coefs(n + 1, 0.0);
-        if(all_coefficients.size())
-            coefs = all_coefficients.back();
-        std :: vector<long double> derivatives(data[0].size() + 1, 0.0);
-        
-        for(i=0;i<steps;i++){
-            GetDerivatives(derivatives, data, coefs, results);
-            for(int j = 0;j<coefs.size();j++){
-                coefs[j] -= lr * derivatives[j];
+        int n = matrix.cols;
+        std :: vector<double> coefs(n + 1, 0.0);
+        if(closed_form){
+            coefs = SolveNormalEquations(matrix, (double)params["l2"]);
+        }
+        else{
+            if(all_coefficients.size())
+                coefs.assign(all_coefficients.back().begin(), all_coefficients.back().end());
+            std :: vector<double> derivatives(n + 1, 0.0);
+            double step = (double)lr / matrix.rows;
+            for(i=0;i<steps;i++){
+                std :: fill(derivatives.begin(), derivatives.end(), 0.0);
+                MatrixKernels :: AccumulateGradient(matrix, 0, matrix.rows, coefs, derivatives);
+                for(j = 0;j<n + 1;j++){
+                    coefs[j] -= step * derivatives[j];
+                }
             }
         }
         
-        DenormalizeCoefficients(coefs, means, std_devs, mean_y, std_dev_y);
+        std :: vector<long double> result(coefs.begin(), coefs.end());
+        DenormalizeCoefficients(result, means, std_devs, mean_y, std_dev_y);
         
-        std :: cout << "Final coefficients: " << coefs;
-        all_coefficients.push_back(coefs);
+        std :: cout << "Final coefficients: " << result;
+        all_coefficients.push_back(result);
         return;
     }
     
+    // Splits each sample into features and its trailing label
+    DataMatrix ToMatrix(const std :: vector <std :: vector<long double> >& data) {
+        DataMatrix m;
+        m.rows = data.size();
+        m.cols = data.empty() ? 0 : (int)data[0].size() - 1;
+        m.x.resize((size_t)m.rows * m.cols);
+        m.y.resize(m.rows);
+        for(int i=0;i<m.rows;i++){
+            double* row = m.Row(i);
+            for(int j=0;j<m.cols;j++){
+                row[j] = (double)data[i][j];
+            }
+            m.y[i] = (double)data[i].back();
+        }
+        return m;
+    }
+    
+    // Same as NormalizeData on a DataMatrix. Constant columns are zeroed, so they get a zero coefficient.
+    void NormalizeMatrix(DataMatrix& m, std :: vector<long double>& means, std :: vector<long double>& std_devs, long double& mean_y, long double& std_dev_y) {
+        int n = m.cols;
+        int datasize = m.rows;
+        int i, j;
+        std :: vector<double> sum(n, 0.0), sq(n, 0.0);
+        for(i=0; i<datasize; i++){
+            MatrixKernels :: Axpy(sum.data(), 1.0, m.Row(i), n);
+        }
+        for(j=0; j<n; j++){
+            sum[j] /= datasize;
+        }
+        for(i=0; i<datasize; i++){
+            const double* row = m.Row(i);
+            for(j=0; j<n; j++){
+                sq[j] += (row[j] - sum[j]) * (row[j] - sum[j]);
+            }
+        }
+        std :: vector<double> scale(n, 0.0);
+        means.assign(sum.begin(), sum.end());
+        std_devs.resize(n);
+        for(j=0; j<n; j++){
+            std_devs[j] = std :: sqrt(sq[j] / datasize);
+            scale[j] = std_devs[j] != 0 ? 1.0 / (double)std_devs[j] : 0.0;
+        }
+        for(i=0; i<datasize; i++){
+            double* row = m.Row(i);
+            for(j=0; j<n; j++){
+                row[j] = (row[j] - sum[j]) * scale[j];
+            }
+        }
+
+        double my = 0.0, sy = 0.0;
+        for(i=0; i<datasize; i++){
+            my += m.y[i];
+        }
+        my /= datasize;
+        for(i=0; i<datasize; i++){
+            sy += (m.y[i] - my) * (m.y[i] - my);
+        }
+        sy = std :: sqrt(sy / datasize);
+        for(i=0; i<datasize; i++){
+            if(sy != 0){
+                m.y[i] = (m.y[i] - my) / sy;
+            }
+        }
+        mean_y = my;
+        std_dev_y = sy;
+    }
+    
+    // Least squares on normalized data: the features are centered, so the intercept is the mean of y
+    // and only the M x M system X^T X w = X^T y is left. One pass accumulates the upper triangle.
+    std :: vector<double> SolveNormalEquations(const DataMatrix& m, double l2 = 0.0) {
+        int n = m.cols;
+        std :: vector<double> xtx((size_t)n * n, 0.0), xty(n, 0.0);
+        double mean_y = 0.0;
+        for(int i=0;i<m.rows;i++){
+            const double* row = m.Row(i);
+            for(int a=0;a<n;a++){
+                MatrixKernels :: Axpy(xtx.data() + (size_t)a * n + a, row[a], row + a, n - a);
+            }
+            MatrixKernels :: Axpy(xty.data(), m.y[i], row, n);
+            mean_y += m.y[i];
+        }
+        for(int a=0;a<n;a++){
+            for(int b=a+1;b<n;b++){
+                xtx[(size_t)b * n + a] = xtx[(size_t)a * n + b];
+            }
+        }
+        std :: vector<double> w = MatrixKernels :: CholeskySolve(xtx, xty, n, l2 * m.rows);
+        std :: vector<double> coefs(n + 1);
+        coefs[0] = m.rows ? mean_y / m.rows : 0.0;
+        std :: copy(w.begin(), w.end(), coefs.begin() + 1);
+        return coefs;
+    }
+    
+    // Out-of-core training: the data is never held whole, only chunk_rows samples at a time.
+    // Parameters: lr, epochs, batch_size, threads (0 = every hardware thread), chunk_rows,
+    // shuffle (non-zero shuffles the batch order inside each chunk).
+    void TrainStream(SampleSource& source, std :: map<std :: string, long double>parameters = {}) {
+        std :: map<std :: string, long double>params;
+        params["lr"] = 0.01;
+        params["epochs"] = 5;
+        params["batch_size"] = 256;
+        params["threads"] = 1;
+        params["chunk_rows"] = 65536;
+        params["shuffle"] = 1.0;
+        
+        for(auto p : parameters){
+            params[p.first] = p.second;
+        }
+        
+        double lr = (double)params["lr"];
+        int epochs = (int)params["epochs"];
+        int batch_size = std :: max(1, (int)params["batch_size"]);
+        int threads = (int)params["threads"];
+        if(threads <= 0) threads = std :: max(1u, std :: thread :: hardware_concurrency());
+        int chunk_rows = std :: max(batch_size, (int)params["chunk_rows"]);
+        bool shuffle = (params["shuffle"] != 0.0);
+        
+        DataMatrix chunk;
+        RunningStats stats;
+        source.Rewind();
+        while(source.Next(chunk, chunk_rows)){
+            stats.Add(chunk);
+        }
+        if(stats.count == 0) throw std :: runtime_error("TrainStream: no samples");
+        
+        int n = chunk.cols;
+        std :: vector<long double> means(stats.mean.begin(), stats.mean.end()), std_devs(n);
+        std :: vector<double> scale(n);
+        for(int j=0;j<n;j++){
+            std_devs[j] = stats.StdDev(j);
+            scale[j] = std_devs[j] != 0 ? 1.0 / (double)std_devs[j] : 0.0;
+        }
+        double mean_y = stats.mean_y, std_dev_y = stats.StdDevY();
+        double scale_y = std_dev_y != 0 ? 1.0 / std_dev_y : 1.0;
+        
+        GradientWorkers workers(threads);
+        std :: vector<double> coefs(n + 1, 0.0), grad;
+        std :: vector<int> batches;
+        for(int epoch=0;epoch<epochs;epoch++){
+            source.Rewind();
+            while(source.Next(chunk, chunk_rows)){
+                for(int i=0;i<chunk.rows;i++){
+                    double* row = chunk.Row(i);
+                    for(int j=0;j<n;j++){
+                        row[j] = (row[j] - stats.mean[j]) * scale[j];
+                    }
+                    chunk.y[i] = (chunk.y[i] - mean_y) * scale_y;
+                }
+                batches.clear();
+                for(int from=0;from<chunk.rows;from+=batch_size){
+                    batches.push_back(from);
+                }
+                if(shuffle) VectorOperations :: Shuffle(batches);
+                for(int from : batches){
+                    int to = std :: min(chunk.rows, from + batch_size);
+                    workers.Run(chunk, from, to, coefs, grad);
+                    double step = lr / (to - from);
+                    for(int j=0;j<=n;j++){
+                        coefs[j] -= step * grad[j];
+                    }
+                }
+            }
+        }
+        
+        std :: vector<long double> result(coefs.begin(), coefs.end());
+        DenormalizeCoefficients(result, means, std_devs, mean_y, std_dev_y);
+        
+        std :: cout << "Final coefficients: " << result;
+        all_coefficients.push_back(result);
+    }
+    
     void NormalizeData(std :: vector <std :: vector<long double> >& data, std :: vector<long double>& results, std :: vector<long double>& means, std :: vector<long double>& std_devs, long double& mean_y, long double& std_dev_y) {
         int n = data[0].size();
         means.resize(n, 0.0);
@@ -158,6 +662,10 @@ public:
         coefs[0] = coefs[0] * std_dev_y + mean_y;
         
         for(int i = 1; i <= n; i++){
+            if(std_devs[i - 1] == 0){
+                coefs[i] = 0.0;
+                continue;
+            }
             coefs[i] = (coefs[i] * std_dev_y) / std_devs[i - 1];
             coefs[0] -= (means[i - 1] * coefs[i]);
         }
@@ -269,6 +777,17 @@ int32_t main(){
 
     std::cout << "Estimate for x = {5.0, 3.0}: " << estimated_y << std::endl;
 
+    // Exact least squares fit, no learning rate or step count involved
+    LinearRegression exact;
+    exact.Train(data, {{"solver", 1}});
+    std::cout << "Closed form estimate for x = {5.0, 3.0}: " << exact.Estimate(test_x) << std::endl;
+
+    // Streaming mini-batch SGD, the same call works on a CsvSource("train.csv") for data that does not fit in memory
+    LinearRegression streamed;
+    IteratorSource<std::vector<std::vector<long double>>::iterator> source(data.begin(), data.end());
+    streamed.TrainStream(source, {{"epochs", 50}, {"batch_size", 16}, {"lr", 0.05}});
+    std::cout << "Streamed estimate for x = {5.0, 3.0}: " << streamed.Estimate(test_x) << std::endl;
+
     return 0;
 }
 
@@ -10,9 +10,13 @@
 
     How It Works:
     - Elements can be dynamically added and removed using functions like push_back, pop_back, and resize.
-    - Capacity grows by doubling when more space is needed, and shrinks when the vector is mostly empty.
+    - Capacity grows by doubling when more space is needed. It only shrinks on request:
+      shrink_to_fit(), or set_auto_shrink(true) to halve it whenever the vector is at most 25% full.
+    - Storage is uninitialized memory (std::allocator, or malloc/realloc and memcpy for trivially
+      copyable T), elements are constructed in place and moved when the buffer grows.
     - Elements are accessed via operator[], with bounds checking that throws a custom ExceptionVector on invalid access.
-    - Copy constructor and assignment operator perform deep copies.
+    - Copy constructor and assignment operator perform deep copies, move constructor and move assignment steal the buffer.
+    - reserve(), capacity(), emplace_back() and push_back(T&&) behave like their std::vector counterparts.
     - Supports construction from initializer lists, size with default value, and copying from other Vectors.
 
     Additional Operators and Functions:
@@ -21,15 +25,17 @@
     - Compound assignment operators (+=) for both Vector and scalar addition.
     - Comparison operators (==, !=, <, <=, >, >=) perform lexicographical comparison.
     - prefixsum: Returns a Vector of prefix sums, with an optional modular version.
+      prefixsum_inplace and prefixsum_into write to the vector itself or a caller buffer instead,
+      prefixsum_parallel splits the scan across threads. 32/64-bit integers use an AVX2 kernel when available.
     - getsum: Returns the sum of elements in a given range, also with a modular version.
-    - insert and insert_k: Insert single or multiple elements at a specified position.
+    - insert and insert_k: Insert single or multiple elements at a specified position, with one shift of the tail.
     - begin() and end() return raw pointers, enabling pointer-based iteration.
     - Overloaded stream insertion and extraction operators facilitate easy I/O.
 
     Differences From std::vector:
-    - Does not implement advanced features like move semantics, custom allocators, or full iterator support.
+    - Does not implement advanced features like custom allocators or full iterator support.
     - Exception handling is done via a simple custom ExceptionVector class.
-    - Capacity shrinking is aggressive (halves capacity if vector is less than 25% full).
+    - Automatic capacity shrinking is available as an opt-in policy (set_auto_shrink).
     - Bounds checking is always enabled on element access (unlike std::vector's unchecked operator[]).
     - Includes custom functions like modular prefix sums which std::vector doesn't provide.
 */
@@ -37,7 +43,22 @@
 #include <initializer_list>
 #include <string>
 #include <ostream>
+#include <istream>
 #include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+#include "instrumentation.h"
+#include <cstdint>
+#include <thread>
+#include <vector>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VECTOR_X86_SIMD 1
+#endif
 
 class ExceptionVector{
 public:
@@ -49,6 +70,99 @@ private:
     std::string _text;
 };
 
+// Inclusive prefix sum kernels used by Vector. in and out may point to the same buffer.
+struct vector_scan_kernels {
+    static bool has_avx2() {
+#ifdef VECTOR_X86_SIMD
+        static const bool ok = __builtin_cpu_supports("avx2");
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+#ifdef VECTOR_X86_SIMD
+    // Both kernels scan 32 bytes in registers (shift-and-add within each 128-bit half,
+    // then the low half's total is added to the high half) and carry the last lane forward.
+    // They return how many elements were processed, the caller finishes the tail.
+    __attribute__((target("avx2"))) static size_t scan32_avx2(const uint32_t* in, uint32_t* out, size_t n, uint32_t carry) {
+        __m256i c = _mm256_set1_epi32(int(carry));
+        const __m256i last = _mm256_set1_epi32(7);
+        size_t i = 0;
+        for(; i + 8 <= n; i += 8){
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+            x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+            __m256i low = _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08), 0xFF);
+            x = _mm256_add_epi32(_mm256_add_epi32(x, low), c);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+            c = _mm256_permutevar8x32_epi32(x, last);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2"))) static size_t scan64_avx2(const uint64_t* in, uint64_t* out, size_t n, uint64_t carry) {
+        __m256i c = _mm256_set1_epi64x((long long)carry);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for(; i + 4 <= n; i += 4){
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+            __m256i low = _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(x, 0x55), 0xF0);
+            x = _mm256_add_epi64(_mm256_add_epi64(x, low), c);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+            c = _mm256_permute4x64_epi64(x, 0xFF);
+        }
+        return i;
+    }
+#endif
+
+    // 32 and 64-bit integers are scanned as their unsigned counterparts, same bits either way.
+    template<typename T>
+    using lane_type = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+
+    template<typename T>
+    static constexpr bool simd_type() {
+        return std::is_integral<T>::value and !std::is_same<T, bool>::value and (sizeof(T) == 4 or sizeof(T) == 8);
+    }
+
+    // out[k] = carry + in[0] + ... + in[k] for k < n, returns the last sum.
+    template<typename T>
+    static T scan(const T* in, T* out, size_t n, T carry) {
+        size_t i = simd_scan(in, out, n, carry, std::integral_constant<bool, simd_type<T>()>());
+        if(i > 0) carry = out[i-1];
+        for(; i < n; i++){
+            carry = carry + in[i];
+            out[i] = carry;
+        }
+        return carry;
+    }
+
+    // Same as scan but starts from in[0] instead of a carry, so T needs no zero value.
+    template<typename T>
+    static T scan_first(const T* in, T* out, size_t n) {
+        out[0] = in[0];
+        return scan(in + 1, out + 1, n - 1, out[0]);
+    }
+
+private:
+    template<typename T>
+    static size_t simd_scan(const T*, T*, size_t, const T&, std::false_type) { return 0; }
+
+    template<typename T>
+    static size_t simd_scan(const T* in, T* out, size_t n, const T& carry, std::true_type) {
+#ifdef VECTOR_X86_SIMD
+        if(has_avx2()){
+            using L = lane_type<T>;
+            if(sizeof(T) == 4) return scan32_avx2(reinterpret_cast<const uint32_t*>(in), reinterpret_cast<uint32_t*>(out), n, uint32_t(L(carry)));
+            return scan64_avx2(reinterpret_cast<const uint64_t*>(in), reinterpret_cast<uint64_t*>(out), n, uint64_t(L(carry)));
+        }
+#endif
+        (void)in; (void)out; (void)n; (void)carry;
+        return 0;
+    }
+};
+
 template<typename T>
 class Vector{
 public:
@@ -58,92 +172,67 @@ public:
         _head = nullptr;
     }
 
-    Vector(const size_t initial_size) {
-        if(initial_size < 0){
-            throw ExceptionVector("Initial size must be a non-negative integer.");
-        }
-        if(initial_size == 0){
-            _size = 0;
-            _capacity = 0;
-            _head = nullptr;
-            return;
+    Vector(const size_t initial_size) : Vector() {
+        _reallocate(initial_size);
+        for(size_t i = 0; i < initial_size; i++){
+            new (_head + i) T();
         }
         _size = initial_size;
-        _capacity = initial_size;
-        _head = new T[_capacity];
     }
 
-    Vector(const size_t initial_size, const T initial_value) {
-        if(initial_size < 0){
-            throw ExceptionVector("Initial size must be a non-negative integer.");
-        }
-        if(initial_size == 0){
-            _size = 0;
-            _capacity = 0;
-            _head = nullptr;
-            return;
-        }
+    Vector(const size_t initial_size, const T& initial_value) : Vector() {
+        _reallocate(initial_size);
+        std::uninitialized_fill_n(_head, initial_size, initial_value);
         _size = initial_size;
-        _capacity = initial_size;
-        _head = new T[_capacity];
-        T each(initial_value);
-        for(size_t i = 0; i < _size; i++){
-            _head[i] = each;
-        }
     }
 
-    Vector(const Vector<T>& rhs) {
-        if(rhs._size == 0){
-            _size = 0;
-            _capacity = 0;
-            _head = nullptr;
-            return;
-        }
+    Vector(const Vector<T>& rhs) : Vector() {
+        _reallocate(rhs._size);
+        _copy_construct(rhs._head, rhs._size, _head);
+        _size = rhs._size;
+    }
+
+    Vector(Vector<T>&& rhs) noexcept {
         _size = rhs._size;
         _capacity = rhs._capacity;
-        _head = new T[_capacity];
-        for(size_t i = 0; i < _size; i++){
-            _head[i] = rhs._head[i];
-        }
+        _head = rhs._head;
+        _auto_shrink = rhs._auto_shrink;
+        rhs._size = 0;
+        rhs._capacity = 0;
+        rhs._head = nullptr;
     }
 
-    Vector(const std::initializer_list<T> il) {
-        if(il.size() == 0){
-            _size = 0;
-            _capacity = 0;
-            _head = nullptr;
-            return;
-        }
+    Vector(const std::initializer_list<T> il) : Vector() {
+        _reallocate(il.size());
+        _copy_construct(il.begin(), il.size(), _head);
         _size = il.size();
-        _capacity = _size;
-        _head = new T[_size];
-        const T* ptr = il.begin();
-        for(size_t i = 0; i < _size; i++){
-            _head[i] = *ptr;
-            ++ptr;
-        }
     }
 
-    Vector<T> const operator+(const Vector<T> rhs) const {
-        Vector<T> result(*this);
-        for(size_t i = 0; i < rhs._size; i++){
-            result.push_back(rhs._head[i]);
-        }
+    Vector<T> const operator+(const Vector<T>& rhs) const {
+        Vector<T> result;
+        result.reserve(_size + rhs._size);
+        result += *this;
+        result += rhs;
         return result;
     }
 
     Vector<T> const operator+(const T rhs) const {
         Vector<T> result;
+        result.reserve(_size);
         for(size_t i = 0; i < _size; i++){
             result.push_back(_head[i] + rhs);
         }
         return result;
     }
 
-    Vector<T>& operator+=(const Vector<T> rhs) {
-        for(size_t i = 0; i < rhs._size; i++){
-            this->push_back(rhs._head[i]);
+    Vector<T>& operator+=(const Vector<T>& rhs) {
+        if(&rhs == this){
+            Vector<T> copy(rhs);
+            return *this += copy;
         }
+        _grow(_size + rhs._size);
+        _copy_construct(rhs._head, rhs._size, _head + _size);
+        _size += rhs._size;
         return *this;
     }
 
@@ -156,12 +245,25 @@ public:
 
     Vector<T>& operator=(const Vector<T>& rhs) {
         if(&rhs == this) return *this;
+        _destroy(0, _size);
+        _size = 0;
+        if(rhs._size > _capacity) _reallocate(rhs._size);
+        _copy_construct(rhs._head, rhs._size, _head);
+        _size = rhs._size;
+        return *this;
+    }
+
+    Vector<T>& operator=(Vector<T>&& rhs) noexcept {
+        if(&rhs == this) return *this;
+        _destroy(0, _size);
+        _deallocate(_head, _capacity);
         _size = rhs._size;
         _capacity = rhs._capacity;
-        _change_capacity();
-        for(size_t i = 0; i < _size; i++){
-            _head[i] = rhs._head[i];
-        }
+        _head = rhs._head;
+        _auto_shrink = rhs._auto_shrink;
+        rhs._size = 0;
+        rhs._capacity = 0;
+        rhs._head = nullptr;
         return *this;
     }
 
@@ -233,13 +335,37 @@ public:
     }
 
     ~Vector() {
-        delete [] _head;
+        _destroy(0, _size);
+        _deallocate(_head, _capacity);
     }
 
-    void push_back(const T value) {
+    void push_back(const T& value) {
+        if(_size == _capacity){
+            T copy(value);
+            _grow(_size + 1);
+            new (_head + _size) T(std::move(copy));
+        }
+        else{
+            new (_head + _size) T(value);
+        }
         _size++;
-        _change_capacity();
-        _head[_size-1] = value;
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if(_size == _capacity){
+            T value(std::forward<Args>(args)...);
+            _grow(_size + 1);
+            new (_head + _size) T(std::move(value));
+        }
+        else{
+            new (_head + _size) T(std::forward<Args>(args)...);
+        }
+        return _head[_size++];
     }
 
     void pop_back() {
@@ -247,19 +373,46 @@ public:
             throw ExceptionVector("pop_back() function cannot be called for an empty vector");
         }
         _size--;
-        _change_capacity();
+        _destroy(_size, _size + 1);
+        _maybe_shrink();
     }
 
     size_t const size() const {
         return _size;
     }
 
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // Makes room for new_capacity elements, never shrinks.
+    void reserve(const size_t new_capacity) {
+        if(new_capacity > _capacity) _reallocate(new_capacity);
+    }
+
+    // Releases unused capacity.
+    void shrink_to_fit() {
+        if(_capacity > _size) _reallocate(_size);
+    }
+
+    // Off by default. When on, capacity is halved once the vector is at most 25% full.
+    void set_auto_shrink(const bool enabled) {
+        _auto_shrink = enabled;
+        _maybe_shrink();
+    }
+
     void resize(const size_t new_size) {
-        if(new_size < 0){
-            throw ExceptionVector("Vector size must be a non-negative integer");
+        if(new_size > _size){
+            _grow(new_size);
+            for(size_t i = _size; i < new_size; i++){
+                new (_head + i) T();
+            }
+        }
+        else{
+            _destroy(new_size, _size);
         }
         _size = new_size;
-        _change_capacity();
+        _maybe_shrink();
     }
 
     bool empty() const {
@@ -275,37 +428,77 @@ public:
     }
 
     Vector<T> const prefixsum() const {
-        if(_size == 0) return Vector<T>();
-        Vector<T> result({_head[0]});
-        for(size_t i = 1; i < _size; i++){
-            result.push_back(result._head[i-1] + _head[i]);
-        }
+        Vector<T> result = _scan_target();
+        prefixsum_into(result._head);
         return result;
     }
 
+    // Expects mod to fit T with 2*mod still representable, each step is an add and a conditional subtract.
+    // For mint element types use prefixsum() instead, the modulus is already part of T.
     template<typename ModType>
     Vector<T> prefixsum(const ModType& mod) const {
-        if(_size == 0) return Vector<T>();
-        Vector<T> result({_head[0]});
-        for(size_t i = 1; i < _size; i++){
-            result.push_back((result._head[i-1] + _head[i]) % mod);
-        }
+        Vector<T> result = _scan_target();
+        prefixsum_into(result._head, mod);
         return result;
     }
 
+    void prefixsum_inplace() {
+        prefixsum_into(_head);
+    }
+
+    template<typename ModType>
+    void prefixsum_inplace(const ModType& mod) {
+        prefixsum_into(_head, mod);
+    }
+
+    // out must have room for size() elements, it may be begin() itself.
+    void prefixsum_into(T* out) const {
+        if(_size) vector_scan_kernels::scan_first(_head, out, _size);
+    }
+
+    template<typename ModType>
+    void prefixsum_into(T* out, const ModType& mod) const {
+        if(_size) _mod_scan(_head, out, _size, T(mod));
+    }
+
+    // Splits the vector into one block per thread, scans the blocks independently and then adds
+    // the total of all preceding blocks to each of them. threads == 0 uses every hardware thread.
+    // Floating point sums may differ in the last bits from the sequential order.
+    void prefixsum_parallel(T* out, unsigned threads = 0) const {
+        _blocked_scan(_head, out, _size, threads,
+            [](const T* in, T* to, size_t n){ return vector_scan_kernels::scan_first(in, to, n); },
+            [](T* to, size_t n, const T& add){
+                for(size_t i = 0; i < n; i++) to[i] = add + to[i];
+            });
+    }
+
+    template<typename ModType>
+    void prefixsum_parallel(T* out, const ModType& mod, unsigned threads) const {
+        const T m = T(mod);
+        _blocked_scan(_head, out, _size, threads,
+            [m](const T* in, T* to, size_t n){ return _mod_scan(in, to, n, m); },
+            [m](T* to, size_t n, const T& add){
+                for(size_t i = 0; i < n; i++){
+                    T x = to[i] + add;
+                    to[i] = (x < m) ? x : x - m;
+                }
+            });
+    }
+
     T const getsum(const size_t i, const size_t j) const {
         T result(_head[j]);
         if(i>0) result -= _head[i-1];
         return result;
     }
 
+    // Prefix sums must already be reduced, as prefixsum(mod) leaves them.
     template<typename ModType>
     T getsum(const size_t i, const size_t j, const ModType& mod) const {
         T result(_head[j]);
         if(i>0){
-            result -= _head[i-1];
-            result += mod;
-            result %= mod;
+            const T& sub = _head[i-1];
+            if(result < sub) result += T(mod) - sub;
+            else result -= sub;
         }
         return result;
     }
@@ -323,57 +516,177 @@ public:
     }
 
     void const insert(const T& x, const size_t index) {
-        resize(_size + 1);
-        for(size_t i = _size-1; i > index; i--){
-            _head[i] = _head[i-1];
-        }
-        _head[index] = x;
+        insert_k(x, index, 1);
     }
 
-    
-    void const insert_k(const T& x, const int index, const int cnt) {
-        for(size_t i=0; i < cnt; i++){
-            insert(x, index);
+    // Inserts cnt copies of x before index with a single shift of the tail.
+    void const insert_k(const T& x, const size_t index, const size_t cnt) {
+        if(index > _size){
+            throw ExceptionVector("insert index out of range");
+        }
+        if(cnt == 0) return;
+        T value(x);
+        _grow(_size + cnt);
+        size_t tail = _size - index;
+        if(std::is_trivially_copyable<T>::value){
+            if(tail) std::memmove(static_cast<void*>(_head + index + cnt), _head + index, tail * sizeof(T));
+            std::uninitialized_fill_n(_head + index, cnt, value);
+        }
+        else{
+            // the last cnt slots are raw memory: fill them first, then shift and assign
+            for(size_t i = _size + cnt; i-- > index + cnt;){
+                if(i >= _size) new (_head + i) T(std::move(_head[i - cnt]));
+                else _head[i] = std::move(_head[i - cnt]);
+            }
+            for(size_t i = index; i < index + cnt; i++){
+                if(i >= _size) new (_head + i) T(value);
+                else _head[i] = value;
+            }
         }
+        _size += cnt;
     }
 
 private:
     size_t _size;
     size_t _capacity;
     T* _head;
+    bool _auto_shrink = false;
 
-    void _change_capacity() {
-        if(_size > _capacity and _capacity > 0){
-            _capacity *= 2;
-            T* new_head = new T[_capacity];
-            for(size_t i = 0; i < _size; i++){
-                new_head[i] = _head[i];
-            }
-            delete [] _head;
-            _head = new_head;
-        }
-        else if(_size > _capacity and _capacity == 0){
-            _capacity = 1;
-            _head = new T[_capacity];
-            _change_capacity();
-        }
-        else if(_size > 0 and _size*4 <= _capacity){
-            T* new_head = new T[_capacity/2];
-            for(size_t i = 0; i < _size; i++){
-                new_head[i] = _head[i];
-            }
-            delete [] _head;
-            _capacity /= 2;
-            _head = new_head;
+    static constexpr size_t PARALLEL_MIN_BLOCK = 1 << 16;
+
+    // Destination for the copying prefixsum variants, left uninitialized when T allows it.
+    Vector<T> _scan_target() const {
+        if(!std::is_trivially_copyable<T>::value) return Vector<T>(*this);
+        Vector<T> result;
+        result._reallocate(_size);
+        result._size = _size;
+        return result;
+    }
+
+    static T _reduce(T x, const T& m) {
+        if(!(x < m) or x < T()){
+            x %= m;
+            if(x < T()) x += m;
         }
-        else if(_size == 0){
-            _capacity = 0;
-            delete [] _head;
-            _head = nullptr;
+        return x;
+    }
+
+    static T _mod_scan(const T* in, T* out, const size_t n, const T& m) {
+        T carry = _reduce(in[0], m);
+        out[0] = carry;
+        for(size_t i = 1; i < n; i++){
+            carry += _reduce(in[i], m);
+            if(!(carry < m)) carry -= m;
+            out[i] = carry;
         }
-        else{
+        return carry;
+    }
+
+    // scan(in, out, n) prefix sums one block and returns its total.
+    // offset(out, n, add) turns a block's local sums into global ones.
+    template<typename Scan, typename Offset>
+    static void _blocked_scan(const T* in, T* out, const size_t n, unsigned threads, Scan scan, Offset offset) {
+        if(n == 0) return;
+        if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = unsigned(std::min<size_t>(threads, n / PARALLEL_MIN_BLOCK));
+        if(threads <= 1){
+            scan(in, out, n);
             return;
         }
+        std::vector<size_t> bounds(threads + 1);
+        for(unsigned t = 0; t <= threads; t++) bounds[t] = n / threads * t + std::min<size_t>(t, n % threads);
+        auto run = [&](auto&& job){
+            std::vector<std::thread> pool;
+            for(unsigned t = 1; t < threads; t++) pool.emplace_back(job, t);
+            job(0u);
+            for(std::thread& th : pool) th.join();
+        };
+
+        std::vector<T> totals(threads);
+        run([&](unsigned t){
+            totals[t] = scan(in + bounds[t], out + bounds[t], bounds[t+1] - bounds[t]);
+        });
+        // totals[t] becomes the sum of blocks 0..t-1
+        for(unsigned t = 1; t + 1 < threads; t++) offset(&totals[t], 1, totals[t-1]);
+        run([&](unsigned t){
+            if(t > 0) offset(out + bounds[t], bounds[t+1] - bounds[t], totals[t-1]);
+        });
+    }
+
+    // Raw storage: malloc/realloc for trivially copyable T, std::allocator otherwise.
+    static T* _allocate(const size_t n) {
+        if(n == 0) return nullptr;
+        INSTRUMENT_COUNT("vector.allocations");
+        INSTRUMENT_ADD("vector.allocated_bytes", n * sizeof(T));
+        if(std::is_trivially_copyable<T>::value){
+            void* p = std::malloc(n * sizeof(T));
+            if(!p) throw std::bad_alloc();
+            return static_cast<T*>(p);
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    static void _deallocate(T* p, const size_t n) {
+        if(!p) return;
+        if(std::is_trivially_copyable<T>::value) std::free(p);
+        else std::allocator<T>().deallocate(p, n);
+    }
+
+    static void _copy_construct(const T* from, const size_t n, T* to) {
+        if(n == 0) return;
+        if(std::is_trivially_copyable<T>::value) std::memcpy(static_cast<void*>(to), from, n * sizeof(T));
+        else std::uninitialized_copy_n(from, n, to);
+    }
+
+    void _destroy(const size_t from, const size_t to) {
+        if(!std::is_trivially_destructible<T>::value){
+            for(size_t i = from; i < to; i++) _head[i].~T();
+        }
+    }
+
+    // Moves the elements into a block of exactly new_capacity (>= _size) elements.
+    void _reallocate(const size_t new_capacity) {
+        if(new_capacity == _capacity) return;
+        if(std::is_trivially_copyable<T>::value and _head and new_capacity > 0){
+            INSTRUMENT_COUNT("vector.allocations");
+            INSTRUMENT_ADD("vector.allocated_bytes", new_capacity * sizeof(T));
+            void* p = std::realloc(static_cast<void*>(_head), new_capacity * sizeof(T));
+            if(!p) throw std::bad_alloc();
+            _head = static_cast<T*>(p);
+            _capacity = new_capacity;
+            return;
+        }
+        T* new_head = _allocate(new_capacity);
+        if(std::is_nothrow_move_constructible<T>::value or !std::is_copy_constructible<T>::value){
+            std::uninitialized_move_n(_head, _size, new_head);
+        }
+        else{
+            try{
+                std::uninitialized_copy_n(_head, _size, new_head);
+            }
+            catch(...){
+                _deallocate(new_head, new_capacity);
+                throw;
+            }
+        }
+        _destroy(0, _size);
+        _deallocate(_head, _capacity);
+        _head = new_head;
+        _capacity = new_capacity;
+    }
+
+    // Doubles capacity until need elements fit.
+    void _grow(const size_t need) {
+        if(need <= _capacity) return;
+        size_t new_capacity = _capacity ? _capacity : 1;
+        while(new_capacity < need) new_capacity *= 2;
+        _reallocate(new_capacity);
+    }
+
+    void _maybe_shrink() {
+        if(!_auto_shrink) return;
+        if(_size == 0) _reallocate(0);
+        else if(_size*4 <= _capacity) _reallocate(_capacity/2);
     }
 };
 
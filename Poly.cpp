@@ -0,0 +1,428 @@
+#include "mint.cpp"
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <cstdint>
+
+/*
+    Here is my implementation for formal power series / polynomials over modular integers.
+
+    Poly<M> stores coefficients of a polynomial over M (static_mint, dynamic_mint, ...),
+    coef[i] being the coefficient of x^i. The default type is Poly<mint> (998244353).
+
+    Transform:
+    - Poly<M>::ntt / intt: iterative radix-4 NTT (one radix-2 pass when log2(n) is odd).
+      Forward is decimation in frequency, inverse is decimation in time, so no bit reversal
+      pass is needed for convolution. Roots are precomputed once per size in contiguous
+      per-level tables, kept per thread and rebuilt when a dynamic_mint modulus changes.
+      Needs 2^k | MOD-1.
+
+    Multiplication (Poly<M>::convolve):
+    - naive O(N*M) for short operands,
+    - Karatsuba O(N^1.58) for medium operands or when MOD has no large 2-power root,
+    - NTT O(N*log(N)) otherwise, with the pointwise products done by mul_batch().
+
+    Newton iterations, all O(N*log(N)) and computed modulo x^n:
+    - inv(n):  1/f, requires f[0] != 0
+    - log(n):  ln f, requires f[0] == 1
+    - exp(n):  e^f, requires f[0] == 0
+    - sqrt(n): f^(1/2), requires the lowest nonzero term to be a square with even degree
+
+    Others:
+    - divmod(g) / operator/ / operator%: polynomial division, O(N*log(N))
+    - evaluate(points): multipoint evaluation via subproduct tree, O(N*log(N)^2)
+    - derivative(), integral(), operator() (Horner evaluation at one point)
+
+    Example Usage:
+        Poly<mint> f = {1, 2, 3};
+        Poly<mint> g = f * f;            // 1 + 4x + 10x^2 + 12x^3 + 9x^4
+        Poly<mint> h = f.inv(5);         // f * h == 1 (mod x^5)
+        std::vector<mint> ys = g.evaluate({0, 1, 2});
+
+    @fortesting
+    https://judge.yosupo.jp/problem/convolution_mod
+    https://judge.yosupo.jp/problem/inv_of_formal_power_series
+    https://judge.yosupo.jp/problem/exp_of_formal_power_series
+    https://judge.yosupo.jp/problem/multipoint_evaluation
+*/
+template <typename M = mint>
+class Poly {
+public:
+    Poly() {}
+    Poly(const std::vector<M>& c) : coef(c) {}
+    Poly(std::vector<M>&& c) : coef(std::move(c)) {}
+    Poly(std::initializer_list<M> il) : coef(il) {}
+    explicit Poly(size_t n) : coef(n) {}
+
+    size_t size() const { return coef.size(); }
+    bool empty() const { return coef.empty(); }
+    void resize(size_t n) { coef.resize(n); }
+    M& operator[](size_t i) { return coef[i]; }
+    const M& operator[](size_t i) const { return coef[i]; }
+    std::vector<M>& data() { return coef; }
+    const std::vector<M>& data() const { return coef; }
+
+    // removes trailing zero coefficients
+    Poly& trim() {
+        while (!coef.empty() && coef.back() == M(0)) coef.pop_back();
+        return *this;
+    }
+    // first n coefficients, zero padded
+    Poly prefix(size_t n) const {
+        std::vector<M> c(coef.begin(), coef.begin() + std::min(n, coef.size()));
+        c.resize(n);
+        return Poly(std::move(c));
+    }
+    Poly reversed() const {
+        std::vector<M> c(coef.rbegin(), coef.rend());
+        return Poly(std::move(c));
+    }
+
+    Poly& operator+=(const Poly& o) {
+        if (o.size() > size()) coef.resize(o.size());
+        for (size_t i = 0; i < o.size(); ++i) coef[i] += o.coef[i];
+        return *this;
+    }
+    Poly& operator-=(const Poly& o) {
+        if (o.size() > size()) coef.resize(o.size());
+        for (size_t i = 0; i < o.size(); ++i) coef[i] -= o.coef[i];
+        return *this;
+    }
+    Poly& operator*=(const Poly& o) { coef = convolve(coef, o.coef); return *this; }
+    Poly& operator*=(const M& k) {
+        for (M& c : coef) c *= k;
+        return *this;
+    }
+    Poly& operator/=(const Poly& o) { return *this = divmod(o).first; }
+    Poly& operator%=(const Poly& o) { return *this = divmod(o).second; }
+    friend Poly operator+(Poly a, const Poly& b) { return a += b; }
+    friend Poly operator-(Poly a, const Poly& b) { return a -= b; }
+    friend Poly operator*(Poly a, const Poly& b) { return a *= b; }
+    friend Poly operator*(Poly a, const M& k) { return a *= k; }
+    friend Poly operator/(Poly a, const Poly& b) { return a /= b; }
+    friend Poly operator%(Poly a, const Poly& b) { return a %= b; }
+    bool operator==(const Poly& o) const { return Poly(*this).trim().coef == Poly(o).trim().coef; }
+    bool operator!=(const Poly& o) const { return !(*this == o); }
+
+    // value at x by Horner's rule
+    M operator()(const M& x) const {
+        M r(0);
+        for (size_t i = coef.size(); i-- > 0;) r = r * x + coef[i];
+        return r;
+    }
+
+    Poly derivative() const {
+        if (coef.size() <= 1) return Poly();
+        std::vector<M> c(coef.size() - 1);
+        for (size_t i = 1; i < coef.size(); ++i) c[i - 1] = coef[i] * M(int64_t(i));
+        return Poly(std::move(c));
+    }
+    Poly integral() const {
+        std::vector<M> c(coef.size() + 1), inv_i(coef.size() + 1);
+        for (size_t i = 1; i <= coef.size(); ++i) inv_i[i] = M(int64_t(i));
+        inv_batch(inv_i);
+        for (size_t i = 0; i < coef.size(); ++i) c[i + 1] = coef[i] * inv_i[i + 1];
+        return Poly(std::move(c));
+    }
+
+    Poly inv(size_t n) const {
+        if (coef.empty() || coef[0] == M(0)) throw std::domain_error("Poly::inv: constant term is zero");
+        Poly g({M(1) / coef[0]});
+        for (size_t len = 1; len < n;) {
+            len *= 2;
+            Poly t = (prefix(len) * g).prefix(len);
+            for (M& c : t.coef) c = M(0) - c;
+            t.coef[0] += M(2);
+            g = (g * t).prefix(len);
+        }
+        return g.prefix(n);
+    }
+
+    Poly log(size_t n) const {
+        if (coef.empty() || coef[0] != M(1)) throw std::domain_error("Poly::log: constant term must be 1");
+        if (n == 0) return Poly();
+        return (derivative() * inv(n)).prefix(n - 1).integral();
+    }
+
+    Poly exp(size_t n) const {
+        if (!coef.empty() && coef[0] != M(0)) throw std::domain_error("Poly::exp: constant term must be 0");
+        Poly g({M(1)});
+        for (size_t len = 1; len < n;) {
+            len *= 2;
+            Poly t = prefix(len) - g.log(len);
+            t.coef[0] += M(1);
+            g = (g * t).prefix(len);
+        }
+        return g.prefix(n);
+    }
+
+    Poly sqrt(size_t n) const {
+        size_t z = 0;
+        while (z < coef.size() && coef[z] == M(0)) ++z;
+        if (z == coef.size() || z >= 2 * n) return Poly(n);
+        if (z % 2) throw std::domain_error("Poly::sqrt: lowest term has odd degree");
+        M root = sqrt_mod(coef[z]);
+        Poly f(std::vector<M>(coef.begin() + z, coef.end()));
+        size_t m = n - z / 2;
+        Poly g({root});
+        const M inv2 = M(1) / M(2);
+        for (size_t len = 1; len < m;) {
+            len *= 2;
+            g = (g + (f.prefix(len) * g.inv(len)).prefix(len)) * inv2;
+        }
+        std::vector<M> c(z / 2, M(0));
+        c.insert(c.end(), g.coef.begin(), g.coef.begin() + std::min(m, g.size()));
+        c.resize(n);
+        return Poly(std::move(c));
+    }
+
+    // {quotient, remainder}
+    std::pair<Poly, Poly> divmod(const Poly& g) const {
+        Poly a = Poly(*this).trim(), b = Poly(g).trim();
+        if (b.empty()) throw std::domain_error("Poly::divmod: division by zero polynomial");
+        if (a.size() < b.size()) return {Poly(), a};
+        size_t k = a.size() - b.size() + 1;
+        Poly q;
+        if (b.size() <= NAIVE_THRESHOLD || k <= NAIVE_THRESHOLD) {
+            q = Poly(k);
+            Poly r = a;
+            M lead_inv = M(1) / b.coef.back();
+            for (size_t i = k; i-- > 0;) {
+                q.coef[i] = r.coef[i + b.size() - 1] * lead_inv;
+                for (size_t j = 0; j < b.size(); ++j) r.coef[i + j] -= q.coef[i] * b.coef[j];
+            }
+            r.resize(b.size() - 1);
+            return {q, r.trim()};
+        }
+        q = (a.reversed().prefix(k) * b.reversed().inv(k)).prefix(k).reversed();
+        Poly r = (a - q * b).prefix(b.size() - 1);
+        return {q, r.trim()};
+    }
+
+    std::vector<M> evaluate(const std::vector<M>& points) const {
+        if (points.empty()) return {};
+        std::vector<Poly> tree;
+        size_t leaves = 1;
+        while (leaves < points.size()) leaves *= 2;
+        tree.assign(2 * leaves, Poly({M(1)}));
+        for (size_t i = 0; i < points.size(); ++i) tree[leaves + i] = Poly({M(0) - points[i], M(1)});
+        for (size_t v = leaves - 1; v >= 1; --v) tree[v] = tree[2 * v] * tree[2 * v + 1];
+        std::vector<M> result(points.size());
+        evaluate_down(*this % tree[1], tree, 1, 0, leaves, points, result);
+        return result;
+    }
+
+    static void ntt(std::vector<M>& a) {
+        size_t n = a.size();
+        const Roots& r = roots(n);
+        size_t lg = 0;
+        while ((size_t(1) << lg) < n) ++lg;
+        if (lg % 2) {
+            size_t h = n / 2;
+            for (size_t j = 0; j < h; ++j) {
+                M u = a[j], v = a[j + h];
+                a[j] = u + v;
+                a[j + h] = (u - v) * r.rt[h + j];
+            }
+        }
+        size_t block = (lg % 2) ? n / 2 : n;
+        for (; block >= 4; block /= 4) {
+            size_t q = block / 4;
+            for (size_t s = 0; s < n; s += block) {
+                M* p = a.data() + s;
+                for (size_t j = 0; j < q; ++j) {
+                    M x0 = p[j], x1 = p[j + q], x2 = p[j + 2 * q], x3 = p[j + 3 * q];
+                    M t0 = x0 + x2, t1 = x0 - x2, t2 = x1 + x3, t3 = (x1 - x3) * r.imag;
+                    p[j] = t0 + t2;
+                    p[j + q] = (t0 - t2) * r.rt[q + j];
+                    p[j + 2 * q] = (t1 + t3) * r.rt[2 * q + j];
+                    p[j + 3 * q] = (t1 - t3) * r.rt3[q + j];
+                }
+            }
+        }
+    }
+
+    static void intt(std::vector<M>& a) {
+        size_t n = a.size();
+        const Roots& r = roots(n);
+        size_t lg = 0;
+        while ((size_t(1) << lg) < n) ++lg;
+        size_t top = (lg % 2) ? n / 2 : n;
+        for (size_t block = 4; block <= top; block *= 4) {
+            size_t q = block / 4;
+            for (size_t s = 0; s < n; s += block) {
+                M* p = a.data() + s;
+                for (size_t j = 0; j < q; ++j) {
+                    M z0 = p[j], z1 = p[j + q] * r.irt[q + j], z2 = p[j + 2 * q] * r.irt[2 * q + j], z3 = p[j + 3 * q] * r.irt3[q + j];
+                    M t0 = z0 + z1, t2 = z0 - z1, t1 = z2 + z3, t3 = (z2 - z3) * r.iimag;
+                    p[j] = t0 + t1;
+                    p[j + 2 * q] = t0 - t1;
+                    p[j + q] = t2 + t3;
+                    p[j + 3 * q] = t2 - t3;
+                }
+            }
+        }
+        if (lg % 2) {
+            size_t h = n / 2;
+            for (size_t j = 0; j < h; ++j) {
+                M u = a[j], v = a[j + h] * r.irt[h + j];
+                a[j] = u + v;
+                a[j + h] = u - v;
+            }
+        }
+        M inv_n = M(1) / M(int64_t(n));
+        for (M& x : a) x *= inv_n;
+    }
+
+    static bool ntt_supported(size_t n) {
+        return (int64_t(M::mod()) - 1) % int64_t(n) == 0;
+    }
+
+    static std::vector<M> convolve(const std::vector<M>& a, const std::vector<M>& b) {
+        if (a.empty() || b.empty()) return {};
+        size_t need = a.size() + b.size() - 1, sz = 1;
+        while (sz < need) sz *= 2;
+        if (std::min(a.size(), b.size()) <= NAIVE_THRESHOLD) return naive(a, b);
+        if (std::max(a.size(), b.size()) <= KARATSUBA_THRESHOLD || !ntt_supported(sz)) return karatsuba(a, b);
+        std::vector<M> fa(a), fb(b);
+        fa.resize(sz);
+        fb.resize(sz);
+        ntt(fa);
+        ntt(fb);
+        mul_batch(fa, fb);
+        intt(fa);
+        fa.resize(need);
+        return fa;
+    }
+
+private:
+    std::vector<M> coef;
+
+    static constexpr size_t NAIVE_THRESHOLD = 32;
+    static constexpr size_t KARATSUBA_THRESHOLD = 48;
+
+    /*
+        rt[k + j] = w_{2k}^j and rt3[k + j] = w_{4k}^{3j} for every power of two k and j < k,
+        where w_m is a primitive m-th root of unity; irt / irt3 hold the inverses.
+        imag is w_4, the multiplier by "i" inside the radix-4 butterfly.
+        The tables belong to the modulus they were built for and are thread_local, so threads
+        transforming at the same time never share (or race on) one cache.
+    */
+    struct Roots {
+        size_t n = 0;
+        uint64_t mod = 0;
+        std::vector<M> rt, rt3, irt, irt3;
+        M imag, iimag;
+    };
+
+    static const Roots& roots(size_t n) {
+        static thread_local Roots r;
+        if (r.mod == M::mod() && n <= r.n) return r;
+        if (!ntt_supported(n)) throw std::domain_error("Poly::ntt: modulus has no root of unity of this order");
+        M g = primitive_root();
+        r.n = n;
+        r.mod = M::mod();
+        r.rt.assign(n, M(1));
+        r.irt.assign(n, M(1));
+        r.rt3.assign(n, M(1));
+        r.irt3.assign(n, M(1));
+        for (size_t k = 1; k < n; k *= 2) {
+            M w = M::fast_pow(g, (int64_t(M::mod()) - 1) / int64_t(2 * k)), iw = M(1) / w;
+            M w3 = M::fast_pow(g, (int64_t(M::mod()) - 1) / int64_t(4 * k) * 3), iw3 = M(1) / w3;
+            for (size_t j = 1; j < k; ++j) {
+                r.rt[k + j] = r.rt[k + j - 1] * w;
+                r.irt[k + j] = r.irt[k + j - 1] * iw;
+                if (4 * k <= n) {
+                    r.rt3[k + j] = r.rt3[k + j - 1] * w3;
+                    r.irt3[k + j] = r.irt3[k + j - 1] * iw3;
+                }
+            }
+        }
+        r.imag = (n >= 4) ? M::fast_pow(g, (int64_t(M::mod()) - 1) / 4) : M(1);
+        r.iimag = M(1) / r.imag;
+        return r;
+    }
+
+    static M primitive_root() {
+        int64_t p = M::mod(), phi = p - 1, x = phi;
+        std::vector<int64_t> factors;
+        for (int64_t d = 2; d * d <= x; ++d) {
+            if (x % d == 0) {
+                factors.push_back(d);
+                while (x % d == 0) x /= d;
+            }
+        }
+        if (x > 1) factors.push_back(x);
+        for (int64_t g = 2;; ++g) {
+            bool ok = true;
+            for (int64_t f : factors) {
+                if (M::fast_pow(M(g), phi / f) == M(1)) { ok = false; break; }
+            }
+            if (ok) return M(g);
+        }
+    }
+
+    // Tonelli-Shanks
+    static M sqrt_mod(const M& a) {
+        int64_t p = M::mod();
+        if (a == M(0) || p == 2) return a;
+        if (M::fast_pow(a, (p - 1) / 2) != M(1)) throw std::domain_error("Poly::sqrt: constant term is not a quadratic residue");
+        int64_t q = p - 1, s = 0;
+        while (q % 2 == 0) { q /= 2; ++s; }
+        M z(2);
+        while (M::fast_pow(z, (p - 1) / 2) == M(1)) z += M(1);
+        M c = M::fast_pow(z, q), x = M::fast_pow(a, (q + 1) / 2), t = M::fast_pow(a, q);
+        int64_t m = s;
+        while (t != M(1)) {
+            int64_t i = 0;
+            M tt = t;
+            while (tt != M(1)) { tt *= tt; ++i; }
+            M b = c;
+            for (int64_t j = 0; j < m - i - 1; ++j) b *= b;
+            x *= b;
+            c = b * b;
+            t *= c;
+            m = i;
+        }
+        return x;
+    }
+
+    static std::vector<M> naive(const std::vector<M>& a, const std::vector<M>& b) {
+        std::vector<M> c(a.size() + b.size() - 1);
+        for (size_t i = 0; i < a.size(); ++i)
+            for (size_t j = 0; j < b.size(); ++j) c[i + j] += a[i] * b[j];
+        return c;
+    }
+
+    static std::vector<M> karatsuba(const std::vector<M>& a, const std::vector<M>& b) {
+        if (std::min(a.size(), b.size()) <= NAIVE_THRESHOLD) return naive(a, b);
+        size_t m = (std::max(a.size(), b.size()) + 1) / 2;
+        auto lo = [m](const std::vector<M>& x) { return std::vector<M>(x.begin(), x.begin() + std::min(m, x.size())); };
+        auto hi = [m](const std::vector<M>& x) { return x.size() > m ? std::vector<M>(x.begin() + m, x.end()) : std::vector<M>(); };
+        std::vector<M> a0 = lo(a), a1 = hi(a), b0 = lo(b), b1 = hi(b);
+        std::vector<M> z0 = karatsuba(a0, b0);
+        std::vector<M> z2 = (a1.empty() || b1.empty()) ? std::vector<M>() : karatsuba(a1, b1);
+        for (size_t i = 0; i < a1.size(); ++i) a0[i] += a1[i];
+        for (size_t i = 0; i < b1.size(); ++i) b0[i] += b1[i];
+        std::vector<M> z1 = karatsuba(a0, b0);
+        for (size_t i = 0; i < z0.size(); ++i) z1[i] -= z0[i];
+        for (size_t i = 0; i < z2.size(); ++i) z1[i] -= z2[i];
+        std::vector<M> c(a.size() + b.size() - 1);
+        for (size_t i = 0; i < z0.size(); ++i) c[i] += z0[i];
+        for (size_t i = 0; i < z1.size() && i + m < c.size(); ++i) c[i + m] += z1[i];
+        for (size_t i = 0; i < z2.size(); ++i) c[i + 2 * m] += z2[i];
+        return c;
+    }
+
+    static void evaluate_down(const Poly& f, const std::vector<Poly>& tree, size_t v, size_t l, size_t r, const std::vector<M>& points, std::vector<M>& result) {
+        if (l >= points.size()) return;
+        if (r - l <= NAIVE_THRESHOLD) {
+            for (size_t i = l; i < std::min(r, points.size()); ++i) result[i] = f(points[i]);
+            return;
+        }
+        size_t mid = (l + r) / 2;
+        evaluate_down(f % tree[2 * v], tree, 2 * v, l, mid, points, result);
+        evaluate_down(f % tree[2 * v + 1], tree, 2 * v + 1, mid, r, points, result);
+    }
+};
@@ -0,0 +1,434 @@
+/*
+    Benchmark suite for the data structures and algorithms in this repository.
+
+    Build and run (every module is included directly, there is nothing else to link):
+        g++ -std=c++17 -O2 -march=native -pthread benchmark.cpp -o benchmark
+        ./benchmark [--quick] [--filter=SUBSTRING] [--min-time=SECONDS] > results.json
+
+    Add -DALGORITHMS_INSTRUMENT to also record the hot path counters of instrumentation.h
+    (allocations, recursion depth, heap pushes, rebalances) for every benchmark.
+
+    Output is one JSON document:
+    {"benchmarks": [{"name": ..., "params": {...}, "iterations": ..., "seconds_per_iteration": ...,
+                     "items_per_second": ..., "counters": {...}}, ...]}
+    counters are totals over all timed iterations, divide by "iterations" for per run values.
+
+    Each benchmark runs once untimed, then repeats until --min-time seconds (default 0.5) have passed.
+    --quick shrinks the inputs for a fast smoke run.
+
+    Covered:
+    - BigInt multiply / divide / parse / print across sizes, plus a Karatsuba threshold sweep
+      (NTT disabled) for tuning KARATSUBA_THRESHOLD
+    - mint multiply and divide throughput, scalar and batched
+    - SuffixArray builds (SA-IS, prefix doubling, parallel) and Hash push / lookup / find on several corpora
+    - Random position insert into IndexedList, BTreeIndexedList and std::vector
+    - Vector push_back and the prefix sum variants against std::vector
+    - Dijkstra (adjacency list, CSR with every queue, bidirectional), many-to-many and delta-stepping on random graphs
+    - Closest pair (divide and conquer, grid) and k-d tree queries
+*/
+
+#include "BigInt.cpp"
+#include "Poly.cpp"
+#include "string_algorithms.cpp"
+#include "IndexedList.cpp"
+#include "MyVector.cpp"
+#include "graph_algorithms.cpp"
+#include "geometry_algorithms.cpp"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused
+template<typename T>
+inline void do_not_optimize(const T& value){
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+class BenchmarkRunner{
+public:
+    BenchmarkRunner(double min_time, const std::string& filter) : min_time(min_time), filter(filter) {}
+
+    /*
+        @brief
+        Times f, reporting it under name with the given parameters
+
+        @param
+        params - {"key", value} pairs, printed as a JSON object
+        items - work items in one call of f (elements, queries, ...), for items_per_second; 0 to omit
+    */
+    void run(const std::string& name, const std::vector<std::pair<std::string, double> >& params, double items, const std::function<void()>& f){
+        if(!filter.empty() && name.find(filter) == std::string::npos) return;
+        f();
+        instrument::reset();
+        long long iterations = 0;
+        double elapsed = 0;
+        auto start = std::chrono::steady_clock::now();
+        do{
+            f();
+            iterations++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while(elapsed < min_time);
+
+        std::ostringstream os;
+        os.precision(9);
+        os << "{\"name\": \"" << name << "\", \"params\": {";
+        for(size_t i = 0; i < params.size(); i++){
+            if(i) os << ", ";
+            os << "\"" << params[i].first << "\": " << params[i].second;
+        }
+        os << "}, \"iterations\": " << iterations << ", \"seconds_per_iteration\": " << elapsed / iterations;
+        if(items > 0) os << ", \"items_per_second\": " << items * iterations / elapsed;
+        os << ", \"counters\": ";
+        instrument::report_json(os);
+        os << "}";
+        results.push_back(os.str());
+        std::cerr << name << " " << elapsed / iterations << " s" << std::endl;
+    }
+
+    void print(std::ostream& os) const {
+        os << "{\"benchmarks\": [\n";
+        for(size_t i = 0; i < results.size(); i++){
+            os << "  " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        os << "]}" << std::endl;
+    }
+
+private:
+    double min_time;
+    std::string filter;
+    std::vector<std::string> results;
+};
+
+static std::mt19937_64 bench_rng(20240601);
+
+static std::string random_digits(size_t n){
+    std::string s(n, '0');
+    for(char& c : s) c = char('0' + bench_rng() % 10);
+    s[0] = char('1' + bench_rng() % 9);
+    return s;
+}
+
+// Text corpora with different suffix structure
+static std::string make_corpus(const std::string& kind, size_t n){
+    std::string s(n, 'a');
+    if(kind == "dna"){
+        const char letters[] = "acgt";
+        for(char& c : s) c = letters[bench_rng() % 4];
+    }
+    else if(kind == "random"){
+        for(char& c : s) c = char('a' + bench_rng() % 26);
+    }
+    else if(kind == "periodic"){
+        for(size_t i = 0; i < n; i++) s[i] = "abcabcabd"[i % 9];
+    }
+    else{
+        // words from a small vocabulary, lots of repeated substrings like natural text
+        std::vector<std::string> words;
+        for(int i = 0; i < 500; i++){
+            std::string w(2 + bench_rng() % 8, 'a');
+            for(char& c : w) c = char('a' + bench_rng() % 26);
+            words.push_back(w);
+        }
+        s.clear();
+        while(s.size() < n){
+            s += words[std::min<size_t>(words.size() - 1, (size_t)(std::abs(std::normal_distribution<double>(0, 80)(bench_rng))))];
+            s += ' ';
+        }
+        s.resize(n);
+    }
+    return s;
+}
+
+static void bench_bigint(BenchmarkRunner& runner, bool quick){
+    std::vector<size_t> sizes = quick ? std::vector<size_t>{1000, 10000} : std::vector<size_t>{1000, 10000, 100000, 1000000};
+    for(size_t digits : sizes){
+        BigInt a(random_digits(digits)), b(random_digits(digits));
+        runner.run("bigint.multiply", {{"digits", (double)digits}}, 0, [&]{
+            BigInt c = a * b;
+            do_not_optimize(c);
+        });
+        BigInt num(random_digits(2 * digits)), den(random_digits(digits));
+        runner.run("bigint.divide", {{"digits", (double)digits}}, 0, [&]{
+            BigInt q = num / den;
+            do_not_optimize(q);
+        });
+        std::string text = random_digits(digits);
+        runner.run("bigint.parse", {{"digits", (double)digits}}, (double)digits, [&]{
+            BigInt x(text);
+            do_not_optimize(x);
+        });
+        runner.run("bigint.to_string", {{"digits", (double)digits}}, (double)digits, [&]{
+            std::string out = a;
+            do_not_optimize(out);
+        });
+    }
+
+    // schoolbook vs Karatsuba crossover, with NTT out of the way
+    size_t saved_ntt = BigInt::ntt_threshold(), saved_karatsuba = BigInt::karatsuba_threshold();
+    BigInt::set_ntt_threshold(SIZE_MAX);
+    size_t digits = quick ? 20000 : 100000;
+    BigInt a(random_digits(digits)), b(random_digits(digits));
+    for(size_t threshold : {8, 16, 32, 64, 128, 256, 512, 1024, 2048}){
+        BigInt::set_karatsuba_threshold(threshold);
+        runner.run("bigint.karatsuba_threshold", {{"digits", (double)digits}, {"threshold_limbs", (double)threshold}}, 0, [&]{
+            BigInt c = a * b;
+            do_not_optimize(c);
+        });
+    }
+    BigInt::set_karatsuba_threshold(saved_karatsuba);
+    BigInt::set_ntt_threshold(saved_ntt);
+}
+
+static void bench_mint(BenchmarkRunner& runner, bool quick){
+    size_t n = quick ? 1 << 14 : 1 << 20;
+    std::vector<mint> a(n), b(n);
+    for(size_t i = 0; i < n; i++){
+        a[i] = mint(bench_rng() % mint::mod());
+        b[i] = mint(1 + bench_rng() % (mint::mod() - 1));
+    }
+    runner.run("mint.mul", {{"n", (double)n}}, (double)n, [&]{
+        for(size_t i = 0; i < n; i++) a[i] *= b[i];
+        do_not_optimize(a[0]);
+    });
+    runner.run("mint.mul_batch", {{"n", (double)n}}, (double)n, [&]{
+        mul_batch(a, b);
+        do_not_optimize(a[0]);
+    });
+    size_t m = n / 16;
+    runner.run("mint.div", {{"n", (double)m}}, (double)m, [&]{
+        for(size_t i = 0; i < m; i++) a[i] /= b[i];
+        do_not_optimize(a[0]);
+    });
+    runner.run("mint.inv_batch", {{"n", (double)n}}, (double)n, [&]{
+        std::vector<mint> c(b);
+        inv_batch(c);
+        do_not_optimize(c[0]);
+    });
+}
+
+static void bench_strings(BenchmarkRunner& runner, bool quick){
+    size_t n = quick ? 1 << 16 : 1 << 20;
+    for(const std::string kind : {"dna", "random", "periodic", "text"}){
+        std::string text = make_corpus(kind, n);
+        int id = kind == "dna" ? 0 : kind == "random" ? 1 : kind == "periodic" ? 2 : 3;
+        std::vector<std::pair<std::string, double> > params = {{"corpus", (double)id}, {"length", (double)n}};
+        runner.run("suffix_array.sa_is/" + kind, params, (double)n, [&]{
+            StringAlgorithms::SuffixArray sa;
+            do_not_optimize(sa.calculate(text));
+        });
+        runner.run("suffix_array.doubling/" + kind, params, (double)n, [&]{
+            StringAlgorithms::SuffixArray sa;
+            do_not_optimize(sa.calculate_doubling(text));
+        });
+        runner.run("suffix_array.parallel/" + kind, params, (double)n, [&]{
+            StringAlgorithms::SuffixArray sa;
+            do_not_optimize(sa.calculate_parallel(text));
+        });
+
+        // the corpus cut into 32 character records
+        std::vector<std::string_view> records;
+        std::string_view view(text);
+        for(size_t i = 0; i + 32 <= n; i += 32) records.push_back(view.substr(i, 32));
+        runner.run("hash.push_back/" + kind, params, (double)records.size(), [&]{
+            Hash h(Hash::storage_mode::borrowed);
+            for(std::string_view r : records) h.push_back(r);
+            do_not_optimize(h);
+        });
+        runner.run("hash.push_back_m61/" + kind, params, (double)records.size(), [&]{
+            Hash h(Hash::storage_mode::borrowed, Hash::hash_mode::mersenne61);
+            for(std::string_view r : records) h.push_back(r);
+            do_not_optimize(h);
+        });
+        Hash h(Hash::storage_mode::borrowed);
+        for(std::string_view r : records) h.push_back(r);
+        h.build_index();
+        runner.run("hash.get_single/" + kind, params, (double)records.size(), [&]{
+            uint64_t sum = 0;
+            for(std::string_view r : records) sum += (uint64_t)h.get_single(r);
+            do_not_optimize(sum);
+        });
+        runner.run("hash.find/" + kind, params, (double)records.size(), [&]{
+            int64_t sum = 0;
+            for(std::string_view r : records) sum += h.find(r);
+            do_not_optimize(sum);
+        });
+    }
+}
+
+static void bench_indexed_list(BenchmarkRunner& runner, bool quick){
+    std::vector<size_t> sizes = quick ? std::vector<size_t>{10000} : std::vector<size_t>{10000, 100000, 1000000};
+    for(size_t n : sizes){
+        std::vector<size_t> positions(n);
+        for(size_t i = 0; i < n; i++) positions[i] = bench_rng() % (i + 1);
+        runner.run("indexed_list.random_insert", {{"n", (double)n}}, (double)n, [&]{
+            IndexedList<int> list;
+            for(size_t i = 0; i < n; i++) list.insert(positions[i], (int)i);
+            do_not_optimize(list);
+        });
+        runner.run("btree_list.random_insert", {{"n", (double)n}}, (double)n, [&]{
+            BTreeIndexedList<int> list;
+            for(size_t i = 0; i < n; i++) list.insert(positions[i], (int)i);
+            do_not_optimize(list);
+        });
+        if(n <= 100000){
+            runner.run("std_vector.random_insert", {{"n", (double)n}}, (double)n, [&]{
+                std::vector<int> v;
+                for(size_t i = 0; i < n; i++) v.insert(v.begin() + positions[i], (int)i);
+                do_not_optimize(v);
+            });
+        }
+    }
+}
+
+static void bench_vector(BenchmarkRunner& runner, bool quick){
+    size_t n = quick ? 1 << 18 : 1 << 24;
+    runner.run("vector.push_back", {{"n", (double)n}}, (double)n, [&]{
+        Vector<int64_t> v;
+        for(size_t i = 0; i < n; i++) v.push_back((int64_t)i);
+        do_not_optimize(v);
+    });
+    runner.run("std_vector.push_back", {{"n", (double)n}}, (double)n, [&]{
+        std::vector<int64_t> v;
+        for(size_t i = 0; i < n; i++) v.push_back((int64_t)i);
+        do_not_optimize(v);
+    });
+    Vector<int64_t> values(n);
+    for(size_t i = 0; i < n; i++) values[i] = (int64_t)(bench_rng() % 1000);
+    std::vector<int64_t> plain(values.begin(), values.end()), out(n);
+    Vector<int64_t> target(n);
+    runner.run("vector.prefixsum", {{"n", (double)n}}, (double)n, [&]{
+        do_not_optimize(values.prefixsum());
+    });
+    runner.run("vector.prefixsum_into", {{"n", (double)n}}, (double)n, [&]{
+        values.prefixsum_into(target.begin());
+        do_not_optimize(target);
+    });
+    runner.run("vector.prefixsum_mod", {{"n", (double)n}}, (double)n, [&]{
+        values.prefixsum_into(target.begin(), 1000000007);
+        do_not_optimize(target);
+    });
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    runner.run("vector.prefixsum_parallel", {{"n", (double)n}, {"threads", (double)threads}}, (double)n, [&]{
+        values.prefixsum_parallel(target.begin(), threads);
+        do_not_optimize(target);
+    });
+    runner.run("std_vector.partial_sum", {{"n", (double)n}}, (double)n, [&]{
+        std::partial_sum(plain.begin(), plain.end(), out.begin());
+        do_not_optimize(out);
+    });
+}
+
+static void bench_dijkstra(BenchmarkRunner& runner, bool quick){
+    int n = quick ? 20000 : 1000000, degree = 8;
+    std::vector<std::vector<std::pair<int,int> > > adj(n);
+    std::vector<std::tuple<int,int,int> > edges;
+    for(int v = 0; v < n; v++){
+        for(int k = 0; k < degree; k++){
+            int to = bench_rng() % n, cost = 1 + bench_rng() % 1000;
+            adj[v].push_back({to, cost});
+            edges.emplace_back(v, to, cost);
+        }
+    }
+    GraphAlgorithms::CSRGraph graph(n, edges), reverse = graph.reversed();
+    std::vector<std::pair<std::string, double> > params = {{"nodes", (double)n}, {"edges", (double)edges.size()}};
+    GraphAlgorithms::Dijkstra dijkstra;
+    runner.run("dijkstra.adjacency", params, (double)edges.size(), [&]{
+        do_not_optimize(dijkstra.calculate(adj, 0, n - 1));
+    });
+    const std::pair<const char*, GraphAlgorithms::queue_type> queues[] = {
+        {"binary", GraphAlgorithms::queue_type::binary},
+        {"quaternary", GraphAlgorithms::queue_type::quaternary},
+        {"radix", GraphAlgorithms::queue_type::radix}};
+    for(const auto& q : queues){
+        runner.run(std::string("dijkstra.csr/") + q.first, params, (double)edges.size(), [&]{
+            do_not_optimize(dijkstra.calculate(graph, 0, -1, false, q.second));
+        });
+    }
+
+    std::vector<std::pair<int,int> > queries(100);
+    for(auto& q : queries) q = {(int)(bench_rng() % n), (int)(bench_rng() % n)};
+    runner.run("dijkstra.point_to_point", params, (double)queries.size(), [&]{
+        for(auto& q : queries) do_not_optimize(dijkstra.calculate(graph, q.first, q.second, false, GraphAlgorithms::queue_type::radix));
+    });
+    runner.run("dijkstra.bidirectional", params, (double)queries.size(), [&]{
+        for(auto& q : queries) do_not_optimize(dijkstra.bidirectional(graph, reverse, q.first, q.second, false, GraphAlgorithms::queue_type::radix));
+    });
+    std::vector<int> depots(quick ? 8 : 32);
+    for(int& d : depots) d = bench_rng() % n;
+    runner.run("dijkstra.many_to_many", {{"nodes", (double)n}, {"depots", (double)depots.size()}}, (double)(depots.size() * depots.size()), [&]{
+        do_not_optimize(GraphAlgorithms::Dijkstra::many_to_many(graph, depots, depots));
+    });
+    GraphAlgorithms::DeltaStepping delta_stepping;
+    for(int64_t delta : {0, 100, 1000}){
+        std::vector<std::pair<std::string, double> > p = params;
+        p.push_back({"delta", (double)delta});
+        runner.run("delta_stepping", p, (double)edges.size(), [&]{
+            do_not_optimize(delta_stepping.calculate(graph, 0, -1, false, delta));
+        });
+    }
+}
+
+static void bench_geometry(BenchmarkRunner& runner, bool quick){
+    std::vector<int> sizes = quick ? std::vector<int>{10000} : std::vector<int>{10000, 100000, 1000000};
+    GeometryAlgorithms geometry;
+    for(int n : sizes){
+        std::vector<std::pair<int,int> > points(n);
+        for(auto& p : points) p = {(int)(bench_rng() % 2000000001) - 1000000000, (int)(bench_rng() % 2000000001) - 1000000000};
+        std::vector<std::pair<double,double> > real_points(points.begin(), points.end());
+        runner.run("closest_pair.divide_and_conquer", {{"n", (double)n}}, (double)n, [&]{
+            do_not_optimize(geometry.find_closest_pair_distance(points));
+        });
+        runner.run("closest_pair.divide_and_conquer_double", {{"n", (double)n}}, (double)n, [&]{
+            do_not_optimize(GeometryAlgorithms::find_closest_pair_squared(real_points));
+        });
+        runner.run("closest_pair.grid", {{"n", (double)n}}, (double)n, [&]{
+            do_not_optimize(GeometryAlgorithms::find_closest_pair_grid(points, 1));
+        });
+        runner.run("kd_tree.build", {{"n", (double)n}}, (double)n, [&]{
+            GeometryAlgorithms::KDTree<int> tree(points);
+            do_not_optimize(tree);
+        });
+        GeometryAlgorithms::KDTree<int> tree(points);
+        int queries = std::min(n, 100000);
+        runner.run("kd_tree.nearest", {{"n", (double)n}, {"queries", (double)queries}}, (double)queries, [&]{
+            int64_t sum = 0;
+            for(int i = 0; i < queries; i++) sum += tree.nearest(points[i], i);
+            do_not_optimize(sum);
+        });
+    }
+}
+
+int main(int argc, char** argv){
+    bool quick = false;
+    double min_time = 0.5;
+    std::string filter;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--quick") quick = true;
+        else if(arg.rfind("--filter=", 0) == 0) filter = arg.substr(9);
+        else if(arg.rfind("--min-time=", 0) == 0) min_time = std::stod(arg.substr(11));
+        else{
+            std::cerr << "usage: " << argv[0] << " [--quick] [--filter=SUBSTRING] [--min-time=SECONDS]" << std::endl;
+            return 1;
+        }
+    }
+    if(quick && min_time == 0.5) min_time = 0.05;
+
+    BenchmarkRunner runner(min_time, filter);
+    bench_bigint(runner, quick);
+    bench_mint(runner, quick);
+    bench_strings(runner, quick);
+    bench_indexed_list(runner, quick);
+    bench_vector(runner, quick);
+    bench_dijkstra(runner, quick);
+    bench_geometry(runner, quick);
+    runner.print(std::cout);
+    return 0;
+}
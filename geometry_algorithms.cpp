@@ -2,12 +2,77 @@
 #include <utility>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <type_traits>
+#include "instrumentation.h"
 class GeometryAlgorithms{
+public:
+    // Squared distances of integer points are exact in int64_t, floating point coordinates keep their own type
+    template<typename T>
+    using squared_t = typename std::conditional<std::is_integral<T>::value, int64_t, T>::type;
+
+    template<typename T>
+    using closest_pair_result = std::pair<squared_t<T>, std::pair<std::pair<T, T>, std::pair<T, T> > >;
+
 private:
-    // Finds the "pythagorean distance" between gicen two points
-    double find_pythagorean_distance(std::pair<int, int> first, std::pair<int, int> second){
-        return sqrt((first.first - second.first)*(first.first - second.first) + (first.second - second.second)*(first.second - second.second));
+    // Finds the squared "pythagorean distance" between given two points
+    template<typename T>
+    static squared_t<T> squared_distance(const std::pair<T, T>& first, const std::pair<T, T>& second){
+        squared_t<T> dx = (squared_t<T>)first.first - second.first;
+        squared_t<T> dy = (squared_t<T>)first.second - second.second;
+        return dx * dx + dy * dy;
+    }
+
+    template<typename T>
+    static closest_pair_result<T> no_pair(const std::vector<std::pair<T, T> >& points){
+        std::pair<T, T> p = points.empty() ? std::pair<T, T>() : points[0];
+        return {std::numeric_limits<squared_t<T> >::max(), {p, p}}; // invalid, give a big number
+    }
+
+    // On entry pts[l, r) is sorted by x, on exit it is sorted by y. buffer and strip are scratch space of size n
+    template<typename T>
+    static void closest_pair_recursive(std::vector<std::pair<T, T> >& pts, std::vector<std::pair<T, T> >& buffer, std::vector<std::pair<T, T> >& strip, int l, int r, closest_pair_result<T>& result){
+        INSTRUMENT_DEPTH("geometry.closest_pair");
+        auto by_y = [](const std::pair<T, T>& a, const std::pair<T, T>& b){
+            return a.second < b.second;
+        };
+        if(r - l <= 3){
+            for(int i=l;i<r;i++){
+                for(int j=i+1;j<r;j++){
+                    squared_t<T> d = squared_distance(pts[i], pts[j]);
+                    if(d < result.first) result = {d, {pts[i], pts[j]}};
+                }
+            }
+            std::sort(pts.begin() + l, pts.begin() + r, by_y);
+            return;
+        }
+        int m = (l + r) / 2;
+        T middle_x = pts[m].first;
+        closest_pair_recursive(pts, buffer, strip, l, m, result);
+        closest_pair_recursive(pts, buffer, strip, m, r, result);
+        std::merge(pts.begin() + l, pts.begin() + m, pts.begin() + m, pts.begin() + r, buffer.begin() + l, by_y);
+        std::copy(buffer.begin() + l, buffer.begin() + r, pts.begin() + l);
+
+        // points within the current best of the dividing line, compared only to the few strip points just below them
+        int count = 0;
+        for(int i=l;i<r;i++){
+            squared_t<T> dx = (squared_t<T>)pts[i].first - middle_x;
+            if(dx * dx >= result.first) continue;
+            for(int j=count-1;j>=0;j--){
+                squared_t<T> dy = (squared_t<T>)pts[i].second - strip[j].second;
+                if(dy * dy >= result.first) break;
+                squared_t<T> d = squared_distance(pts[i], strip[j]);
+                if(d < result.first) result = {d, {strip[j], pts[i]}};
+            }
+            strip[count++] = pts[i];
+        }
     }
+
 public:
     /*
         @brief
@@ -16,21 +81,19 @@ public:
 
         @param
         points - A vector of points
-        
+
         @return
         {minimum distance ,{first point, second point}}
-              
+
         @fortesting
         https://judge.yosupo.jp/problem/closest_pair
-        
+
         Time and space complexity is O(N*log(N)), where N is the number of points
-        
+
         @important note
-        Since the result of algorithm is not always an integer
-        Please change the variable types if needed
-        For example, you may need non-integer points
+        Kept for the integer interface, see find_closest_pair_squared for other coordinate types
     */
-    std::pair<double,std::pair<std::pair<int, int>, std::pair<int, int> > > find_closest_pair_distance(std::vector<std::pair<int,int> > points){
+    std::pair<double,std::pair<std::pair<int, int>, std::pair<int, int> > > find_closest_pair_distance(const std::vector<std::pair<int,int> >& points){
         int n = points.size();
         if(n == 0){
             return {5e9,{{0,0},{0,0}}}; // invalid, give a big number
@@ -38,63 +101,277 @@ public:
         if(n == 1){
             return {5e9,{{points[0].first,points[0].second},{points[0].first,points[0].second}}}; // give a big number
         }
-        bool sorted = true;
-        for(int i=0;i<n-1;i++){
-            if(points[i] > points[i+1]){
-                sorted = false;
-                break;
-            }
+        closest_pair_result<int> result = find_closest_pair_squared(points);
+        return {sqrt((double)result.first), result.second};
+    }
+
+    /*
+        @brief
+        Closest pair by divide and conquer, without square roots and without allocations inside the recursion
+        Points are sorted by x once; every level merges its two halves by y into one scratch buffer,
+        so the strip around the dividing line is already in y order
+
+        @param
+        points - A vector of points, T can be an integer (distances are computed in int64_t) or floating point type
+
+        @return
+        {minimum squared distance, {first point, second point}}, the squared distance is the largest value of its type
+        when there are fewer than two points
+
+        Time complexity is O(N*log(N)), extra space complexity is O(N), where N is the number of points
+
+        @important note
+        Integer coordinates must differ by less than about 2^31 in each axis, so that dx*dx + dy*dy fits in int64_t
+    */
+    template<typename T>
+    static closest_pair_result<T> find_closest_pair_squared(const std::vector<std::pair<T, T> >& points){
+        int n = points.size();
+        closest_pair_result<T> result = no_pair(points);
+        if(n < 2) return result;
+        std::vector<std::pair<T, T> >pts(points), buffer(n), strip(n);
+        std::sort(pts.begin(), pts.end());
+        closest_pair_recursive(pts, buffer, strip, 0, n, result);
+        return result;
+    }
+
+    /*
+        @brief
+        Closest pair by the randomized incremental grid method
+        Points are inserted in random order into a hashed grid whose cells are as wide as the best distance so far,
+        a new point only has to be compared against the 3x3 block of cells around it. Whenever the best distance
+        shrinks the grid is rebuilt with smaller cells, in random order that happens O(1) times per point in expectation
+
+        @param
+        points - A vector of points, T can be an integer or floating point type
+        seed - seed for the insertion order
+
+        @return
+        Same as find_closest_pair_squared
+
+        Expected time complexity is O(N), space complexity is O(N), where N is the number of points
+    */
+    template<typename T>
+    static closest_pair_result<T> find_closest_pair_grid(const std::vector<std::pair<T, T> >& points, uint64_t seed = std::chrono::steady_clock::now().time_since_epoch().count()){
+        int n = points.size();
+        closest_pair_result<T> result = no_pair(points);
+        if(n < 2) return result;
+        std::vector<std::pair<T, T> >pts(points);
+        std::mt19937_64 rng(seed);
+        for(int i=n-1;i>0;i--){
+            std::swap(pts[i], pts[rng() % (i + 1)]);
         }
-        if(!sorted) std::sort(points.begin(), points.end());
-        std::vector<std::pair<int,int> > first_group;
-        std::vector<std::pair<int,int> > second_group;
-        for(int i=0;i<n/2;i++){
-            first_group.push_back(points[i]);
-        }
-        for(int i=n/2;i<n;i++){
-            second_group.push_back(points[i]);
-        }
-        std::pair<double,std::pair<std::pair<int, int>, std::pair<int, int> > > first_group_result = find_closest_pair_distance(first_group);
-        std::pair<double,std::pair<std::pair<int, int>, std::pair<int, int> > > second_group_result = find_closest_pair_distance(second_group);
-        std::pair<double,std::pair<std::pair<int, int>, std::pair<int, int> > > result;
-        std::vector<std::pair<int, int> >first_candidates;
-        std::vector<std::pair<int, int> >second_candidates;
-        if(first_group_result.ff < second_group_result.ff){
-            result = first_group_result;
-        }
-        else{
-            result = second_group_result;
-        }
-        int delimiter = first_group.back().first;
-        for(int i=0;i<first_group.size();i++){
-            if(delimiter - first_group[i].first <= ceil(result.first)){
-                first_candidates.push_back({first_group[i].second, first_group[i].first});
+        T min_x = pts[0].first, min_y = pts[0].second;
+        for(const std::pair<T, T>& p : pts){
+            min_x = std::min(min_x, p.first);
+            min_y = std::min(min_y, p.second);
+        }
+
+        result = {squared_distance(pts[0], pts[1]), {pts[0], pts[1]}};
+        // a duplicate point is already optimal, and a zero cell size would overflow cell_of
+        if(result.first == 0) return result;
+        int table_size = 1;
+        while(table_size < 2 * n) table_size *= 2;
+        std::vector<int64_t>cell_x(table_size), cell_y(table_size);
+        std::vector<int>head(table_size), next(n);
+        double cell = 0;
+
+        auto cell_of = [&](T value, T low){
+            return (int64_t)std::floor(((double)value - (double)low) / cell);
+        };
+        auto slot_of = [&](int64_t x, int64_t y){
+            uint64_t h = (uint64_t)x * 0x9E3779B97F4A7C15ull ^ ((uint64_t)y + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+            int slot = (h ^ (h >> 29)) & (table_size - 1);
+            while(head[slot] != -1 && (cell_x[slot] != x || cell_y[slot] != y)){
+                slot = (slot + 1) & (table_size - 1);
+            }
+            return slot;
+        };
+        auto insert = [&](int i){
+            int64_t x = cell_of(pts[i].first, min_x), y = cell_of(pts[i].second, min_y);
+            int slot = slot_of(x, y);
+            if(head[slot] == -1){
+                cell_x[slot] = x;
+                cell_y[slot] = y;
+            }
+            next[i] = head[slot];
+            head[slot] = i;
+        };
+        // inserts points [0, count) with cells matching the current best, slightly widened against rounding
+        auto rebuild = [&](int count){
+            std::fill(head.begin(), head.end(), -1);
+            cell = std::sqrt((double)result.first) * (1 + 1e-9) + std::numeric_limits<double>::min();
+            for(int i=0;i<count;i++) insert(i);
+        };
+
+        rebuild(2);
+        for(int i=2;i<n;i++){
+            int64_t x = cell_of(pts[i].first, min_x), y = cell_of(pts[i].second, min_y);
+            squared_t<T> best = result.first;
+            int partner = -1;
+            for(int64_t dx=-1;dx<=1;dx++){
+                for(int64_t dy=-1;dy<=1;dy++){
+                    int slot = slot_of(x + dx, y + dy);
+                    for(int j=head[slot];j!=-1;j=next[j]){
+                        squared_t<T> d = squared_distance(pts[i], pts[j]);
+                        if(d < best){
+                            best = d;
+                            partner = j;
+                        }
+                    }
+                }
+            }
+            if(partner == -1){
+                insert(i);
+            }
+            else{
+                result = {best, {pts[partner], pts[i]}};
+                if(result.first == 0) return result;
+                rebuild(i + 1);
             }
         }
-        for(int i=0;i<second_group.size();i++){
-            if(second_group[i].first - delimiter <= ceil(result.first)){
-                second_candidates.push_back({second_group[i].second, second_group[i].first});
+        return result;
+    }
+
+    /*
+        @brief
+        k-d tree over a fixed set of points, built once and queried many times
+        Each node splits its range at the median of the axis with the larger spread; the tree is stored implicitly
+        in one array (the node of range [l, r) is element (l+r)/2), so it needs no pointers
+
+        @param
+        points - the points to index, query answers are indices into this vector
+
+        Build time complexity is O(N*log(N)), space complexity is O(N)
+        A nearest neighbor query takes O(log(N)) on well spread points, O(sqrt(N)) in the worst case
+    */
+    template<typename T>
+    class KDTree{
+    public:
+        KDTree(const std::vector<std::pair<T, T> >& points) : items(points.size()) {
+            for(size_t i=0;i<points.size();i++){
+                items[i] = {points[i], (int)i, 0};
             }
+            build(0, items.size());
+        }
+
+        int size() const {
+            return items.size();
+        }
+
+        // Index of the point closest to query, skipping index exclude (e.g. the query point itself); -1 if there is none
+        int nearest(const std::pair<T, T>& query, int exclude = -1) const {
+            squared_t<T> best = std::numeric_limits<squared_t<T> >::max();
+            int best_id = -1;
+            nearest_recursive(0, items.size(), query, exclude, best, best_id);
+            return best_id;
         }
-        if(second_candidates.size() == 0) return result;
-        std :: sort(first_candidates.begin(), first_candidates.end());
-        std :: sort(second_candidates.begin(), second_candidates.end());
-        int left = 0, right = 0;
-        for(int i=0; i < first_candidates.size();i++){
-            while(left < second_candidates.size()-1 and first_candidates[i].first - second_candidates[left].first > floor(result.first)){
-                left++;
+
+        // Indices of the k points closest to query, nearest first
+        std::vector<int> k_nearest(const std::pair<T, T>& query, int k) const {
+            std::priority_queue<std::pair<squared_t<T>, int> >heap;
+            if(k > 0) k_nearest_recursive(0, items.size(), query, k, heap);
+            std::vector<int>ret(heap.size());
+            for(int i=ret.size()-1;i>=0;i--){
+                ret[i] = heap.top().second;
+                heap.pop();
             }
-            while(right < second_candidates.size()-1 and second_candidates[right+1].first - first_candidates[i].first <= floor(result.first)){
-                right++;
+            return ret;
+        }
+
+        // Indices of all points within distance sqrt(squared_radius) of query, in no particular order
+        std::vector<int> within(const std::pair<T, T>& query, squared_t<T> squared_radius) const {
+            std::vector<int>ret;
+            within_recursive(0, items.size(), query, squared_radius, ret);
+            return ret;
+        }
+
+    private:
+        struct Item{
+            std::pair<T, T> point;
+            int id;
+            char axis;
+        };
+        std::vector<Item>items;
+
+        static T coordinate(const std::pair<T, T>& p, char a){
+            return a == 0 ? p.first : p.second;
+        }
+
+        // Distance from query to the splitting line of node m, squared; diff keeps the sign
+        squared_t<T> plane_distance(int m, const std::pair<T, T>& query, squared_t<T>& diff) const {
+            diff = (squared_t<T>)coordinate(query, items[m].axis) - coordinate(items[m].point, items[m].axis);
+            return diff * diff;
+        }
+
+        void build(int l, int r){
+            if(r - l <= 0) return;
+            INSTRUMENT_DEPTH("geometry.kd_build");
+            T min_x = items[l].point.first, max_x = min_x, min_y = items[l].point.second, max_y = min_y;
+            for(int i=l+1;i<r;i++){
+                min_x = std::min(min_x, items[i].point.first);
+                max_x = std::max(max_x, items[i].point.first);
+                min_y = std::min(min_y, items[i].point.second);
+                max_y = std::max(max_y, items[i].point.second);
             }
-            for(int j=left;j<=right;j++){
-                if(result.first > find_pythagorean_distance(first_candidates[i], second_candidates[j])){
-                    result = {find_pythagorean_distance(first_candidates[i], second_candidates[j]),{first_candidates[i], second_candidates[j]}};
-                    std :: swap(result.second.first.first, result.second.first.second);
-                    std :: swap(result.second.second.first, result.second.second.second);
+            char a = ((squared_t<T>)max_x - min_x >= (squared_t<T>)max_y - min_y) ? 0 : 1;
+            int m = (l + r) / 2;
+            std::nth_element(items.begin() + l, items.begin() + m, items.begin() + r, [a](const Item& x, const Item& y){
+                return coordinate(x.point, a) < coordinate(y.point, a);
+            });
+            items[m].axis = a;
+            build(l, m);
+            build(m + 1, r);
+        }
+
+        void nearest_recursive(int l, int r, const std::pair<T, T>& query, int exclude, squared_t<T>& best, int& best_id) const {
+            if(r - l <= 0) return;
+            int m = (l + r) / 2;
+            if(items[m].id != exclude){
+                squared_t<T> d = squared_distance(query, items[m].point);
+                if(d < best){
+                    best = d;
+                    best_id = items[m].id;
                 }
             }
+            squared_t<T> diff;
+            squared_t<T> plane = plane_distance(m, query, diff);
+            if(diff < 0){
+                nearest_recursive(l, m, query, exclude, best, best_id);
+                if(plane < best) nearest_recursive(m + 1, r, query, exclude, best, best_id);
+            }
+            else{
+                nearest_recursive(m + 1, r, query, exclude, best, best_id);
+                if(plane < best) nearest_recursive(l, m, query, exclude, best, best_id);
+            }
         }
-        return result;
-    }
+
+        void k_nearest_recursive(int l, int r, const std::pair<T, T>& query, int k, std::priority_queue<std::pair<squared_t<T>, int> >& heap) const {
+            if(r - l <= 0) return;
+            int m = (l + r) / 2;
+            squared_t<T> d = squared_distance(query, items[m].point);
+            if((int)heap.size() < k){
+                heap.push({d, items[m].id});
+            }
+            else if(d < heap.top().first){
+                heap.pop();
+                heap.push({d, items[m].id});
+            }
+            squared_t<T> diff;
+            squared_t<T> plane = plane_distance(m, query, diff);
+            int near_l = diff < 0 ? l : m + 1, near_r = diff < 0 ? m : r;
+            int far_l = diff < 0 ? m + 1 : l, far_r = diff < 0 ? r : m;
+            k_nearest_recursive(near_l, near_r, query, k, heap);
+            if((int)heap.size() < k || plane < heap.top().first) k_nearest_recursive(far_l, far_r, query, k, heap);
+        }
+
+        void within_recursive(int l, int r, const std::pair<T, T>& query, squared_t<T> squared_radius, std::vector<int>& ret) const {
+            if(r - l <= 0) return;
+            int m = (l + r) / 2;
+            if(squared_distance(query, items[m].point) <= squared_radius) ret.push_back(items[m].id);
+            squared_t<T> diff;
+            squared_t<T> plane = plane_distance(m, query, diff);
+            if(diff < 0 || plane <= squared_radius) within_recursive(l, m, query, squared_radius, ret);
+            if(diff >= 0 || plane <= squared_radius) within_recursive(m + 1, r, query, squared_radius, ret);
+        }
+    };
 };
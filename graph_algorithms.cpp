@@ -3,9 +3,306 @@
 #include <cstdint>
 #include <climits>
 #include <algorithm>
+#include <tuple>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "instrumentation.h"
 
 class GraphAlgorithms{
 public:
+    /*
+        @brief
+        Compressed sparse row graph: the outgoing edges of node v are edges[offsets[v]] .. edges[offsets[v+1]-1],
+        all in one contiguous array, so a scan over a node's neighbours touches consecutive memory
+
+        Build from an adjacency list ({adjacent_node, cost} pairs like Dijkstra::calculate takes),
+        or from a list of {from, to, cost} edges with a counting sort
+
+        Time and space complexity of construction is O(V+E)
+    */
+    class CSRGraph{
+    public:
+        struct Edge{
+            int to;
+            int cost;
+        };
+
+        CSRGraph() : offsets(1, 0) {}
+
+        CSRGraph(const std::vector<std::vector<std::pair<int,int> > >& adj) : offsets(adj.size() + 1, 0) {
+            for(size_t i = 0; i < adj.size(); i++){
+                offsets[i + 1] = offsets[i] + adj[i].size();
+            }
+            edges.reserve(offsets.back());
+            for(const std::vector<std::pair<int,int> >& list : adj){
+                for(const std::pair<int,int>& u : list){
+                    edges.push_back({u.first, u.second});
+                }
+            }
+        }
+
+        CSRGraph(int n, const std::vector<std::tuple<int,int,int> >& edge_list) : offsets(n + 1, 0), edges(edge_list.size()) {
+            for(const std::tuple<int,int,int>& e : edge_list){
+                offsets[std::get<0>(e) + 1]++;
+            }
+            for(int i = 0; i < n; i++){
+                offsets[i + 1] += offsets[i];
+            }
+            std::vector<int64_t>fill(offsets.begin(), offsets.end() - 1);
+            for(const std::tuple<int,int,int>& e : edge_list){
+                edges[fill[std::get<0>(e)]++] = {std::get<1>(e), std::get<2>(e)};
+            }
+        }
+
+        int size() const {
+            return offsets.size() - 1;
+        }
+
+        int64_t edge_count() const {
+            return edges.size();
+        }
+
+        int degree(int node) const {
+            return offsets[node + 1] - offsets[node];
+        }
+
+        const Edge* begin(int node) const {
+            return edges.data() + offsets[node];
+        }
+
+        const Edge* end(int node) const {
+            return edges.data() + offsets[node + 1];
+        }
+
+        // Same nodes with every edge turned around, for backward searches
+        CSRGraph reversed() const {
+            std::vector<std::tuple<int,int,int> >edge_list;
+            edge_list.reserve(edges.size());
+            for(int v = 0; v < size(); v++){
+                for(const Edge* e = begin(v); e != end(v); e++){
+                    edge_list.emplace_back(e->to, v, e->cost);
+                }
+            }
+            return CSRGraph(size(), edge_list);
+        }
+
+    private:
+        std::vector<int64_t>offsets;
+        std::vector<Edge>edges;
+    };
+
+    /*
+        @brief
+        Priority queues for Dijkstra on {distance, node} entries, all keep their storage across clear()
+        BinaryHeap and QuaternaryHeap accept any keys, RadixHeap needs non-negative keys that never go below
+        the last popped one (always true in Dijkstra with non-negative costs) and makes pop amortized O(log C)
+    */
+    class BinaryHeap{
+    public:
+        void push(int64_t key, int node){
+            INSTRUMENT_COUNT("heap.push");
+            heap.push_back({key, node});
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int64_t,int> >());
+        }
+        std::pair<int64_t,int> pop(){
+            std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<int64_t,int> >());
+            std::pair<int64_t,int> top = heap.back();
+            heap.pop_back();
+            return top;
+        }
+        int64_t top_key() const {
+            return heap[0].first;
+        }
+        bool empty() const {
+            return heap.empty();
+        }
+        void clear(){
+            heap.clear();
+        }
+    private:
+        std::vector<std::pair<int64_t,int> >heap;
+    };
+
+    // Four children per node: half the depth of a binary heap and siblings share a cache line
+    class QuaternaryHeap{
+    public:
+        void push(int64_t key, int node){
+            INSTRUMENT_COUNT("heap.push");
+            size_t i = heap.size();
+            heap.push_back({key, node});
+            while(i > 0){
+                size_t parent = (i - 1) / 4;
+                if(heap[parent].first <= key) break;
+                heap[i] = heap[parent];
+                i = parent;
+            }
+            heap[i] = {key, node};
+        }
+        std::pair<int64_t,int> pop(){
+            std::pair<int64_t,int> top = heap[0], last = heap.back();
+            heap.pop_back();
+            size_t n = heap.size(), i = 0;
+            if(n == 0) return top;
+            while(true){
+                size_t child = 4 * i + 1;
+                if(child >= n) break;
+                size_t best = child, stop = std::min(child + 4, n);
+                for(size_t c = child + 1; c < stop; c++){
+                    if(heap[c].first < heap[best].first) best = c;
+                }
+                if(last.first <= heap[best].first) break;
+                heap[i] = heap[best];
+                i = best;
+            }
+            heap[i] = last;
+            return top;
+        }
+        int64_t top_key() const {
+            return heap[0].first;
+        }
+        bool empty() const {
+            return heap.empty();
+        }
+        void clear(){
+            heap.clear();
+        }
+    private:
+        std::vector<std::pair<int64_t,int> >heap;
+    };
+
+    // Bucket i holds keys whose highest bit differing from the last popped key is bit i-1
+    class RadixHeap{
+    public:
+        void push(int64_t key, int node){
+            INSTRUMENT_COUNT("heap.push");
+            buckets[bucket_of(key)].push_back({key, node});
+            count++;
+        }
+        std::pair<int64_t,int> pop(){
+            refill();
+            std::pair<int64_t,int> top = buckets[0].back();
+            buckets[0].pop_back();
+            count--;
+            return top;
+        }
+        int64_t top_key(){
+            refill();
+            return buckets[0].back().first;
+        }
+        bool empty() const {
+            return count == 0;
+        }
+        void clear(){
+            for(std::vector<std::pair<int64_t,int> >& b : buckets) b.clear();
+            last = 0;
+            count = 0;
+        }
+    private:
+        std::vector<std::pair<int64_t,int> >buckets[65];
+        int64_t last = 0;
+        size_t count = 0;
+
+        int bucket_of(int64_t key) const {
+            uint64_t diff = (uint64_t)key ^ (uint64_t)last;
+            return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+        }
+
+        // Moves the smallest keys into bucket 0
+        void refill(){
+            if(buckets[0].empty()){
+                int i = 1;
+                while(buckets[i].empty()) i++;
+                int64_t smallest = buckets[i][0].first;
+                for(const std::pair<int64_t,int>& e : buckets[i]){
+                    smallest = std::min(smallest, e.first);
+                }
+                last = smallest;
+                for(const std::pair<int64_t,int>& e : buckets[i]){
+                    buckets[bucket_of(e.first)].push_back(e);
+                }
+                buckets[i].clear();
+            }
+        }
+    };
+
+    enum class queue_type{ binary, quaternary, radix };
+
+    /*
+        @brief
+        Per query state of a shortest path search, meant to be kept and reused across queries
+        Holds the distances, parents and heap storage. Entries carry the epoch of the query that wrote them, so starting a new query is O(1)
+        instead of clearing O(V) arrays; only nodes the query touches are ever written
+
+        dist(v) is LLONG_MAX and parent(v) is -1 for nodes the current query has not reached
+    */
+    class Workspace{
+    public:
+        // Starts a new query on a graph with n nodes
+        void reset(int n, bool record_path){
+            if((int)stamp.size() < n){
+                distance.resize(n);
+                prev.resize(n);
+                stamp.resize(n, 0);
+            }
+            if(++epoch == 0){
+                std::fill(stamp.begin(), stamp.end(), 0);
+                epoch = 1;
+            }
+            has_path = record_path;
+        }
+
+        int64_t dist(int node) const {
+            return stamp[node] == epoch ? distance[node] : LLONG_MAX;
+        }
+
+        int parent(int node) const {
+            return (has_path && stamp[node] == epoch) ? prev[node] : -1;
+        }
+
+        void set(int node, int64_t d, int parent_node){
+            stamp[node] = epoch;
+            distance[node] = d;
+            if(has_path) prev[node] = parent_node;
+        }
+
+        bool recorded_path() const {
+            return has_path;
+        }
+
+        /*
+            @brief
+            Same as Dijkstra::find_path, for the last query run on this workspace
+            (which must have been run with find_path = true)
+        */
+        std::vector<int> find_path(int node) const {
+            std::vector<int>ret;
+            if(parent(node) == -1){
+                return {};
+            }
+            while(node != -1){
+                ret.push_back(node);
+                node = parent(node);
+            }
+            std::reverse(ret.begin(), ret.end());
+            return ret;
+        }
+
+        // Queue storage, reused by every query run on this workspace
+        BinaryHeap binary_heap;
+        QuaternaryHeap quaternary_heap;
+        RadixHeap radix_heap;
+
+    private:
+        std::vector<int64_t>distance;
+        std::vector<int>prev;
+        std::vector<uint32_t>stamp;
+        uint32_t epoch = 0;
+        bool has_path = false;
+    };
+
     class Dijkstra{
     public:
         /*
@@ -32,12 +329,12 @@ public:
             int n = adj.size(), node;
             int64_t cost;
             std::vector<bool>visited(n, false);
-            distance.resize(n, LLONG_MAX);
-            if(find_path) prev.resize(n);
+            distance.assign(n, LLONG_MAX);
+            if(find_path) prev.assign(n, -1);
+            last_query = query_kind::adjacency;
             std::priority_queue<std::pair<int64_t,int>, std::vector<std::pair<int64_t,int> >, std::greater<std::pair<int64_t,int> > >pq;
             distance[source] = 0ll;
             pq.push({0ll, source});
-            prev[source] = -1;
             while(!pq.empty()){
                 node = pq.top().second;
                 cost = pq.top().first;
@@ -48,6 +345,7 @@ public:
                     if(distance[u.first] > cost + u.second){
                         distance[u.first] = cost + u.second;
                         pq.push({cost + u.second, u.first});
+                        INSTRUMENT_COUNT("heap.push");
                         if(find_path){
                             prev[u.first] = node;
                         }
@@ -56,6 +354,170 @@ public:
             }
             return distance[target];
         }
+
+        /*
+            @brief
+            Dijkstra on a CSRGraph, reusing the heap and the per node arrays of a Workspace between calls
+            Stops as soon as target is settled, pass target = -1 to compute distances to every node
+            Afterwards distances are read with get_distance(v) (or workspace.dist(v)), and find_path works as before
+
+            @param
+            graph - the graph, costs must be non-negative
+            source - index of the source node
+            target - index of the target node, or -1
+            find_path - set "true" if you will need nodes of one of the shortest paths
+            queue - binary heap, 4-ary heap, or radix heap (integer costs, usually the fastest)
+
+            @return
+            Shortest path from source to target (LLONG_MAX if unreachable), 0 when target is -1
+
+            Time complexity is O((E+V)*log(E)) with the binary and 4-ary heaps, O(E + V*log(C)) with the radix heap,
+            where C is the largest distance, and only the part of the graph reached before target is settled is visited
+            Extra space complexity is O(V+E) once, kept in the workspace and reused by later calls
+        */
+
+        Workspace workspace;
+        int64_t calculate(const CSRGraph& graph, int source, int target = -1, bool find_path = false, queue_type queue = queue_type::binary){
+            last_query = query_kind::workspace;
+            return search(graph, workspace, source, target, find_path, queue);
+        }
+
+        // Multi-source version: every node in sources starts at distance 0, distances are to the nearest source
+        int64_t calculate(const CSRGraph& graph, const std::vector<int>& sources, int target = -1, bool find_path = false, queue_type queue = queue_type::binary){
+            last_query = query_kind::workspace;
+            return search(graph, workspace, sources, target, find_path, queue);
+        }
+
+        // Same as the CSRGraph calculate, with a caller owned workspace
+        static int64_t search(const CSRGraph& graph, Workspace& ws, int source, int target = -1, bool find_path = false, queue_type queue = queue_type::binary){
+            return search(graph, ws, std::vector<int>{source}, target, find_path, queue);
+        }
+
+        static int64_t search(const CSRGraph& graph, Workspace& ws, const std::vector<int>& sources, int target = -1, bool find_path = false, queue_type queue = queue_type::binary){
+            with_queue(ws, queue, [&](auto& pq){
+                run(graph, ws, pq, sources, find_path, [target](int node){ return node == target; });
+            });
+            return target == -1 ? 0 : ws.dist(target);
+        }
+
+        /*
+            @brief
+            Bidirectional Dijkstra for a single source to target query
+            Searches forward from source on graph and backward from target on its reverse at the same time,
+            always growing the side whose queue has the smaller key, and stops once the two smallest keys add up
+            to at least the best source -> target path seen so far. Usually settles far fewer nodes than calculate
+
+            @param
+            graph - the graph, costs must be non-negative
+            reverse - graph.reversed(), built once and reused across queries
+            source, target - the query
+            find_path - set "true" if you will need the nodes of the path, then call find_path(target)
+            queue - same choice as in calculate
+
+            @return
+            Shortest path from source to target, LLONG_MAX if unreachable
+
+            Time complexity is the same as calculate in the worst case
+        */
+
+        Workspace reverse_workspace;
+        int64_t bidirectional(const CSRGraph& graph, const CSRGraph& reverse, int source, int target, bool find_path = false, queue_type queue = queue_type::binary){
+            last_query = query_kind::bidirectional;
+            bidirectional_target = target;
+            return bidirectional_search(graph, reverse, workspace, reverse_workspace, source, target, queue, find_path ? &bidirectional_path : nullptr);
+        }
+
+        // Same as bidirectional, with caller owned workspaces. The path is written to *path when it is not null
+        static int64_t bidirectional_search(const CSRGraph& graph, const CSRGraph& reverse, Workspace& forward, Workspace& backward, int source, int target, queue_type queue = queue_type::binary, std::vector<int>* path = nullptr){
+            int64_t best = LLONG_MAX;
+            int meet_from = -1, meet_to = -1;
+            with_queue(forward, queue, [&](auto& fq){
+                with_queue(backward, queue, [&](auto& bq){
+                    bool record = (path != nullptr);
+                    forward.reset(graph.size(), record);
+                    backward.reset(graph.size(), record);
+                    fq.clear();
+                    bq.clear();
+                    forward.set(source, 0, -1);
+                    backward.set(target, 0, -1);
+                    fq.push(0, source);
+                    bq.push(0, target);
+                    if(source == target) best = 0;
+                    while(!fq.empty() && !bq.empty() && fq.top_key() + bq.top_key() < best){
+                        if(fq.top_key() <= bq.top_key()){
+                            grow(graph, forward, backward, fq, best, meet_from, meet_to, false);
+                        }
+                        else{
+                            grow(reverse, backward, forward, bq, best, meet_from, meet_to, true);
+                        }
+                    }
+                });
+            });
+            if(path != nullptr){
+                path->clear();
+                if(best != LLONG_MAX && source != target){
+                    for(int node = meet_from; node != -1; node = forward.parent(node)){
+                        path->push_back(node);
+                    }
+                    std::reverse(path->begin(), path->end());
+                    for(int node = meet_to; node != -1; node = backward.parent(node)){
+                        path->push_back(node);
+                    }
+                }
+            }
+            return best;
+        }
+
+        /*
+            @brief
+            Distance matrix between sources and targets, answer[i][j] is the shortest path from sources[i] to targets[j]
+            (LLONG_MAX if unreachable). The graph is only read, each thread owns a workspace and takes the next source
+            when it is done; a search stops as soon as every target is settled
+
+            @param
+            graph - the graph, costs must be non-negative
+            threads - number of worker threads, 0 uses every hardware thread
+            queue - same choice as in calculate
+
+            Time complexity is O(S * (E+V)*log(E)) work split over the threads, S = sources.size()
+            Space complexity is O(S*T) for the answer plus O(V) per thread
+        */
+        static std::vector<std::vector<int64_t> > many_to_many(const CSRGraph& graph, const std::vector<int>& sources, const std::vector<int>& targets, unsigned threads = 0, queue_type queue = queue_type::radix){
+            std::vector<std::vector<int64_t> >answer(sources.size(), std::vector<int64_t>(targets.size(), LLONG_MAX));
+            std::vector<char>is_target(graph.size(), 0);
+            int distinct = 0;
+            for(int t : targets){
+                if(!is_target[t]) distinct++;
+                is_target[t] = 1;
+            }
+            if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            threads = std::max(1u, std::min<unsigned>(threads, sources.size()));
+            std::atomic<size_t>next(0);
+            auto worker = [&](){
+                Workspace ws;
+                for(size_t i = next++; i < sources.size(); i = next++){
+                    int remaining = distinct;
+                    with_queue(ws, queue, [&](auto& pq){
+                        run(graph, ws, pq, std::vector<int>{sources[i]}, false, [&](int node){
+                            return is_target[node] && --remaining == 0;
+                        });
+                    });
+                    for(size_t j = 0; j < targets.size(); j++){
+                        answer[i][j] = ws.dist(targets[j]);
+                    }
+                }
+            };
+            std::vector<std::thread>pool;
+            for(unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+            worker();
+            for(std::thread& th : pool) th.join();
+            return answer;
+        }
+
+        int64_t get_distance(int node){
+            if(last_query != query_kind::adjacency) return workspace.dist(node);
+            return distance[node];
+        }
         
         /*
             @brief
@@ -76,17 +538,292 @@ public:
         */
         
         std::vector<int> find_path(int node){
-            std::vector<int>ret;
-            if(prev[node] == -1){
-                return {};
+            if(last_query == query_kind::bidirectional){
+                return node == bidirectional_target ? bidirectional_path : std::vector<int>();
             }
-            while(node != -1){
-                ret.push_back(node);
-                node = prev[node];
+            if(last_query == query_kind::workspace) return workspace.find_path(node);
+            return path_from_parents(prev, node);
+        }
+
+    private:
+        enum class query_kind{ adjacency, workspace, bidirectional };
+        query_kind last_query = query_kind::adjacency;
+        int bidirectional_target = -1;
+        std::vector<int>bidirectional_path;
+
+        template<typename F>
+        static void with_queue(Workspace& ws, queue_type queue, F f){
+            if(queue == queue_type::radix) f(ws.radix_heap);
+            else if(queue == queue_type::quaternary) f(ws.quaternary_heap);
+            else f(ws.binary_heap);
+        }
+
+        // Plain Dijkstra from every node in sources, stops after settling a node for which stop(node) is true
+        template<typename Queue, typename Stop>
+        static void run(const CSRGraph& graph, Workspace& ws, Queue& pq, const std::vector<int>& sources, bool find_path, Stop stop){
+            ws.reset(graph.size(), find_path);
+            pq.clear();
+            for(int source : sources){
+                ws.set(source, 0, -1);
+                pq.push(0, source);
+            }
+            while(!pq.empty()){
+                std::pair<int64_t,int> top = pq.pop();
+                int64_t cost = top.first;
+                int node = top.second;
+                if(cost > ws.dist(node)) continue;
+                if(stop(node)) break;
+                for(const CSRGraph::Edge* e = graph.begin(node); e != graph.end(node); e++){
+                    int64_t next = cost + e->cost;
+                    if(next < ws.dist(e->to)){
+                        ws.set(e->to, next, node);
+                        pq.push(next, e->to);
+                    }
+                }
+            }
+        }
+
+        // One step of bidirectional search on side "self", meeting points are checked against "other"
+        template<typename Queue>
+        static void grow(const CSRGraph& graph, Workspace& self, const Workspace& other, Queue& pq, int64_t& best, int& meet_from, int& meet_to, bool backward){
+            std::pair<int64_t,int> top = pq.pop();
+            int64_t cost = top.first;
+            int node = top.second;
+            if(cost > self.dist(node)) return;
+            for(const CSRGraph::Edge* e = graph.begin(node); e != graph.end(node); e++){
+                int64_t next = cost + e->cost;
+                if(next < self.dist(e->to)){
+                    self.set(e->to, next, node);
+                    pq.push(next, e->to);
+                }
+                int64_t rest = other.dist(e->to);
+                if(rest != LLONG_MAX && next + rest < best){
+                    best = next + rest;
+                    meet_from = backward ? e->to : node;
+                    meet_to = backward ? node : e->to;
+                }
             }
-            std::reverse(ret.begin(), ret.end());
-            return ret;
         }
     };
+    /*
+        @brief
+        Parallel delta-stepping single source shortest paths on a CSRGraph
+        Tentative distances are grouped into buckets of width delta. All nodes of the smallest non-empty bucket
+        are relaxed together by the worker threads: light edges (cost <= delta) first, repeating while the bucket
+        refills, then heavy edges once. Every thread keeps its own buckets and distances are lowered with an
+        atomic compare-and-swap, threads meet at a barrier between phases
+
+        Fills distance and prev exactly like Dijkstra::calculate on an adjacency list, so find_path works the same way.
+        prev is rebuilt from the final distances after the search, any shortest path tree is a valid answer
+
+        @param
+        graph - the graph, costs must be non-negative
+        source - index of the source node
+        target - index of the target node, or -1; the search stops once target's bucket is done
+        find_path - set "true" if you will need nodes of one of the shortest paths, and call find_path function
+        delta - bucket width, 0 picks largest cost / mean out-degree. Small delta approaches Dijkstra (little parallel
+                work per phase), large delta approaches Bellman-Ford (more re-relaxations)
+        threads - number of worker threads, 0 uses every hardware thread
+
+        @return
+        Shortest path from source to target (LLONG_MAX if unreachable), 0 when target is -1
+
+        Time complexity is O(V+E) per phase in the worst case, about O((E+V) * (1 + L/delta) / threads) on graphs
+        with random costs, where L is the largest distance
+        Space complexity is O(V+E)
+    */
+    class DeltaStepping{
+    public:
+        std::vector<int64_t>distance;
+        std::vector<int>prev;
+        int64_t calculate(const CSRGraph& graph, int source, int target = -1, bool find_path = false, int64_t delta = 0, unsigned threads = 0){
+            int n = graph.size();
+            if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            threads = std::max(1u, std::min<unsigned>(threads, std::max(1, n / 1024)));
+
+            int64_t max_cost = 0;
+            for(int v = 0; v < n; v++){
+                for(const CSRGraph::Edge* e = graph.begin(v); e != graph.end(v); e++){
+                    max_cost = std::max<int64_t>(max_cost, e->cost);
+                }
+            }
+            if(delta <= 0){
+                int64_t mean_degree = std::max<int64_t>(1, graph.edge_count() / std::max(1, n));
+                delta = std::max<int64_t>(1, max_cost / mean_degree);
+            }
+
+            std::unique_ptr<std::atomic<int64_t>[]>dist(new std::atomic<int64_t>[n]);
+            for(int v = 0; v < n; v++) dist[v].store(LLONG_MAX, std::memory_order_relaxed);
+            dist[source].store(0, std::memory_order_relaxed);
+
+            // absolute bucket b lives in slot b % slots, nothing pending is ever more than slots - 1 buckets ahead
+            size_t slots = max_cost / delta + 2;
+            std::vector<std::vector<std::vector<int> > >buckets(threads, std::vector<std::vector<int> >(slots));
+            std::vector<std::vector<int> >settled(threads);
+            buckets[0][0].push_back(source);
+
+            std::vector<int>frontier;
+            std::atomic<size_t>cursor(0);
+            int64_t current = 0;
+            bool finished = false, bucket_empty = false;
+            Barrier barrier(threads);
+
+            auto relax = [&](unsigned t, int node, int64_t cost, bool light){
+                for(const CSRGraph::Edge* e = graph.begin(node); e != graph.end(node); e++){
+                    if((e->cost <= delta) != light) continue;
+                    int64_t next = cost + e->cost;
+                    int64_t old = dist[e->to].load(std::memory_order_relaxed);
+                    while(next < old && !dist[e->to].compare_exchange_weak(old, next, std::memory_order_relaxed)){}
+                    if(next < old){
+                        INSTRUMENT_COUNT("delta_stepping.bucket_push");
+                        buckets[t][(next / delta) % slots].push_back(e->to);
+                    }
+                }
+            };
+            // thread 0 only, moves every thread's copy of the current bucket into frontier
+            auto gather = [&](){
+                frontier.clear();
+                size_t slot = current % slots;
+                for(unsigned t = 0; t < threads; t++){
+                    frontier.insert(frontier.end(), buckets[t][slot].begin(), buckets[t][slot].end());
+                    buckets[t][slot].clear();
+                }
+                cursor.store(0, std::memory_order_relaxed);
+                bucket_empty = frontier.empty();
+            };
+            auto worker = [&](unsigned t){
+                const size_t CHUNK = 256;
+                while(true){
+                    if(t == 0){
+                        // smallest absolute bucket with something in it, stale entries included
+                        finished = true;
+                        int64_t from = current;
+                        for(size_t k = 0; k < slots && finished; k++){
+                            size_t slot = (from + k) % slots;
+                            for(unsigned u = 0; u < threads; u++){
+                                if(!buckets[u][slot].empty()){
+                                    finished = false;
+                                    current = from + k;
+                                    break;
+                                }
+                            }
+                        }
+                        if(target != -1 && dist[target].load(std::memory_order_relaxed) < current * delta) finished = true;
+                        if(!finished){
+                            INSTRUMENT_COUNT("delta_stepping.buckets");
+                            gather();
+                        }
+                    }
+                    barrier.wait();
+                    if(finished) break;
+                    while(true){
+                        if(bucket_empty) break;
+                        while(true){
+                            size_t from = cursor.fetch_add(CHUNK, std::memory_order_relaxed);
+                            if(from >= frontier.size()) break;
+                            size_t to = std::min(frontier.size(), from + CHUNK);
+                            for(size_t i = from; i < to; i++){
+                                int node = frontier[i];
+                                int64_t cost = dist[node].load(std::memory_order_relaxed);
+                                if(cost / delta != current) continue;
+                                settled[t].push_back(node);
+                                relax(t, node, cost, true);
+                            }
+                        }
+                        barrier.wait();
+                        if(t == 0) gather();
+                        barrier.wait();
+                    }
+                    for(int node : settled[t]){
+                        relax(t, node, dist[node].load(std::memory_order_relaxed), false);
+                    }
+                    settled[t].clear();
+                    barrier.wait();
+                    if(t == 0) current++;
+                }
+            };
+            std::vector<std::thread>pool;
+            for(unsigned t = 1; t < threads; t++) pool.emplace_back(worker, t);
+            worker(0);
+            for(std::thread& th : pool) th.join();
+
+            distance.resize(n);
+            for(int v = 0; v < n; v++) distance[v] = dist[v].load(std::memory_order_relaxed);
+            if(find_path) build_parents(graph, source);
+            return target == -1 ? 0 : distance[target];
+        }
+
+        std::vector<int> find_path(int node){
+            return path_from_parents(prev, node);
+        }
+
+    private:
+        class Barrier{
+        public:
+            Barrier(unsigned count) : count(count) {}
+            void wait(){
+                if(count == 1) return;
+                std::unique_lock<std::mutex>lock(mutex);
+                unsigned gen = generation;
+                if(++arrived == count){
+                    arrived = 0;
+                    generation++;
+                    cv.notify_all();
+                    return;
+                }
+                cv.wait(lock, [&]{ return gen != generation; });
+            }
+        private:
+            std::mutex mutex;
+            std::condition_variable cv;
+            unsigned count, arrived = 0, generation = 0;
+        };
+
+        // Picks a parent for every reached node among its tight incoming edges. Positive tight edges point to
+        // strictly smaller distances; nodes reached only through zero cost edges are attached by a BFS over
+        // tight zero cost edges, so the parents never form a cycle
+        void build_parents(const CSRGraph& graph, int source){
+            int n = graph.size();
+            prev.assign(n, -1);
+            bool zero_edges = false;
+            for(int u = 0; u < n; u++){
+                if(distance[u] == LLONG_MAX) continue;
+                for(const CSRGraph::Edge* e = graph.begin(u); e != graph.end(u); e++){
+                    if(e->cost == 0) zero_edges = true;
+                    else if(prev[e->to] == -1 && e->to != source && distance[u] + e->cost == distance[e->to]) prev[e->to] = u;
+                }
+            }
+            if(!zero_edges) return;
+            std::vector<int>queue;
+            for(int v = 0; v < n; v++){
+                if(v == source || prev[v] != -1) queue.push_back(v);
+            }
+            for(size_t i = 0; i < queue.size(); i++){
+                int u = queue[i];
+                for(const CSRGraph::Edge* e = graph.begin(u); e != graph.end(u); e++){
+                    if(e->cost == 0 && e->to != source && prev[e->to] == -1 && distance[e->to] == distance[u]){
+                        prev[e->to] = u;
+                        queue.push_back(e->to);
+                    }
+                }
+            }
+        }
+    };
+
+    // Walks prev back from node, empty when node has no parent (the source or an unreachable node)
+    static std::vector<int> path_from_parents(const std::vector<int>& prev, int node){
+        std::vector<int>ret;
+        if(prev[node] == -1){
+            return {};
+        }
+        while(node != -1){
+            ret.push_back(node);
+            node = prev[node];
+        }
+        std::reverse(ret.begin(), ret.end());
+        return ret;
+    }
+
     Dijkstra dijkstra_obj;
+    DeltaStepping delta_stepping_obj;
 };
@@ -0,0 +1,141 @@
+#ifndef ALGORITHMS_INSTRUMENTATION_H
+#define ALGORITHMS_INSTRUMENTATION_H
+
+/*
+    Optional hot path counters shared by the modules in this repository.
+
+    Compile with -DALGORITHMS_INSTRUMENT to turn them on. Without it every macro expands
+    to nothing, so the instrumented code is exactly the uninstrumented code.
+
+    INSTRUMENT_COUNT("name")         counts how many times the line runs
+    INSTRUMENT_ADD("name", amount)   adds amount (e.g. bytes allocated)
+    INSTRUMENT_DEPTH("name")         counts calls of the enclosing function and tracks the deepest
+                                     nesting reached on any thread (recursion depth)
+
+    Each call site looks its counter up by name once, later hits are a relaxed atomic add.
+    Sites with the same name share one counter. instrument::report_json() writes all of them,
+    instrument::reset() zeroes them (e.g. between benchmark runs).
+
+    Names used in this repository:
+    bigint.multiply_spans, suffix_array.sa_is,       recursion depth of Karatsuba, SA-IS,
+    geometry.closest_pair, geometry.kd_build         closest pair and k-d tree construction
+    vector.allocations, vector.allocated_bytes       Vector buffer (re)allocations and their size
+    indexed_list.allocations                         IndexedList block buffer growth
+    indexed_list.splits, indexed_list.merges,        rebalancing of IndexedList and BTreeIndexedList
+    btree_list.splits, btree_list.rebalances
+    heap.push                                        Dijkstra queue pushes, every queue type
+    delta_stepping.buckets, delta_stepping.bucket_push
+*/
+
+#ifdef ALGORITHMS_INSTRUMENT
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace instrument{
+    struct counter{
+        std::atomic<uint64_t> value{0};
+        std::atomic<uint64_t> peak{0};
+
+        void raise_peak(uint64_t v){
+            uint64_t old = peak.load(std::memory_order_relaxed);
+            while(v > old && !peak.compare_exchange_weak(old, v, std::memory_order_relaxed)){}
+        }
+    };
+
+    struct registry{
+        std::mutex mutex;
+        std::map<std::string, std::unique_ptr<counter> > counters;
+    };
+
+    inline registry& global(){
+        static registry r;
+        return r;
+    }
+
+    inline counter& get(const char* name){
+        registry& r = global();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        std::unique_ptr<counter>& c = r.counters[name];
+        if(!c) c.reset(new counter);
+        return *c;
+    }
+
+    class depth_guard{
+    public:
+        depth_guard(counter& c, int& depth) : depth(depth) {
+            c.value.fetch_add(1, std::memory_order_relaxed);
+            c.raise_peak(++depth);
+        }
+        ~depth_guard(){
+            --depth;
+        }
+    private:
+        int& depth;
+    };
+
+    inline void reset(){
+        registry& r = global();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for(auto& entry : r.counters){
+            entry.second->value.store(0, std::memory_order_relaxed);
+            entry.second->peak.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // {"name": {"count": c, "peak": p}, ...} for counters hit since the last reset(),
+    // peak is only meaningful for INSTRUMENT_DEPTH sites
+    inline void report_json(std::ostream& os){
+        registry& r = global();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        os << "{";
+        bool first = true;
+        for(auto& entry : r.counters){
+            if(entry.second->value.load() == 0) continue;
+            if(!first) os << ", ";
+            first = false;
+            os << "\"" << entry.first << "\": {\"count\": " << entry.second->value.load()
+               << ", \"peak\": " << entry.second->peak.load() << "}";
+        }
+        os << "}";
+    }
+}
+
+#define INSTRUMENT_CAT_INNER(a, b) a##b
+#define INSTRUMENT_CAT(a, b) INSTRUMENT_CAT_INNER(a, b)
+
+#define INSTRUMENT_ADD(name, amount) do{ \
+        static instrument::counter& instrument_site = instrument::get(name); \
+        instrument_site.value.fetch_add((uint64_t)(amount), std::memory_order_relaxed); \
+    } while(0)
+
+#define INSTRUMENT_COUNT(name) INSTRUMENT_ADD(name, 1)
+
+#define INSTRUMENT_DEPTH(name) \
+    static instrument::counter& INSTRUMENT_CAT(instrument_site_, __LINE__) = instrument::get(name); \
+    static thread_local int INSTRUMENT_CAT(instrument_depth_, __LINE__) = 0; \
+    instrument::depth_guard INSTRUMENT_CAT(instrument_guard_, __LINE__)(INSTRUMENT_CAT(instrument_site_, __LINE__), INSTRUMENT_CAT(instrument_depth_, __LINE__))
+
+#else
+
+#include <ostream>
+
+namespace instrument{
+    inline void reset(){}
+    inline void report_json(std::ostream& os){
+        os << "{}";
+    }
+}
+
+#define INSTRUMENT_ADD(name, amount) do{} while(0)
+#define INSTRUMENT_COUNT(name) do{} while(0)
+#define INSTRUMENT_DEPTH(name) do{} while(0)
+
+#endif
+
+#endif
@@ -2,20 +2,35 @@
 #include <cstdint>
 #include <type_traits>
 #include <stdexcept>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MINT_X86_SIMD 1
+#endif
 
 /*
     This is my implementation for Modular Integers.
-    
-    Modular Integer Class: mint
 
-    This class represents integers under modular arithmetic with a fixed modulus.
-    It supports safe and efficient modular operations including addition, subtraction,
+    Modular Integer Classes: static_mint<MOD>, dynamic_mint<ID> and mint
+
+    These classes represent integers under modular arithmetic.
+    They support safe and efficient modular operations including addition, subtraction,
     multiplication, division (via modular inverse), and exponentiation.
 
+    - static_mint<MOD> has a compile-time modulus (odd, below 2^31) and stores values in
+      32-bit Montgomery form, so multiplication needs no hardware division.
+    - dynamic_mint<ID> has a modulus chosen at run time with dynamic_mint<ID>::set_mod(m)
+      and uses Barrett reduction. The modulus must be below 2^31, and different ID values
+      give independent moduli.
+    - mint is static_mint<998244353>, the usual NTT prime.
+
     Key Features:
     - Automatic normalization ensures that all values remain in the range [0, MOD).
     - Overloaded operators for intuitive usage: +, -, *, /, ==, !=, etc.
     - Bit-shift operators << and >> are redefined as multiplication/division by powers of 2 (modular).
+    - Combinatorics<M> keeps lazily grown factorial / inverse factorial tables for O(1) C(n, k).
     - Disallowed operations like comparisons and modulus (%) are explicitly guarded via exceptions.
 
     Example Usage:
@@ -26,168 +41,590 @@
         mint e = a << 3;        // a * 2^3 mod MOD
         std::cout << e << '\n'; // output e's value
 
+        using hmint = static_mint<1000000007>;
+        using rmint = dynamic_mint<0>;
+        rmint::set_mod(1000034507);
+        rmint f = rmint(7) * 3;
+
     Note:
     - This implementation is tailored for use in competitive programming, number theory, or cryptographic contexts.
+    - Division assumes the modulus is prime.
 */
 
-class mint {
-private:
-    int64_t val;
-    static constexpr int64_t MOD = 998244353;
+template <typename M> class Combinatorics;
 
+// Operators shared by every modular integer type. M provides value(), mod(), +=, -=, *=, ==.
+template <typename M>
+class mint_base {
+protected:
     static inline void undefined() {
         throw std::logic_error("Undefined behavior for mint class");
     }
 
-    static inline mint fast_pow(mint x, int64_t y) {
-        if (y == 0) return mint(1);
-        mint a = fast_pow(x, y / 2);
-        if (y & 1) return a * a * x;
-        return a * a;
+public:
+    // x^y by binary exponentiation, negative y raises the inverse of x
+    static inline M fast_pow(M x, int64_t y) {
+        if (y < 0) {
+            x = fast_pow(x, int64_t(M::mod()) - 2);
+            y = -y;
+        }
+        M r(1);
+        for (; y; y >>= 1, x *= x)
+            if (y & 1) r *= x;
+        return r;
     }
 
-    void normalize() {
-        ((val %= MOD) += MOD) %= MOD;
-    }
+    operator int64_t() const { return static_cast<const M&>(*this).value(); }
 
-public:
-    mint() : val(0ll) { }
-    mint(int64_t val) : val(val) {
-        normalize();
-    }
-    mint(const mint& other) = default;
-    ~mint() = default;
-    mint& operator=(const mint& other) = default;
-    operator int64_t() const { return val; }
-    mint& operator+=(const mint& other) {
-        val += other.val;
-        if (val >= MOD) val -= MOD;
-        return *this;
-    }
-    mint& operator-=(const mint& other) {
-        val -= other.val;
-        if (val < 0) val += MOD;
-        return *this;
-    }
-    mint& operator*=(const mint& other) {
-        val = (val * other.val) % MOD;
-        return *this;
+    M& operator/=(const M& other) {
+        M& self = static_cast<M&>(*this);
+        self *= fast_pow(other, M::mod() - 2);
+        return self;
     }
-    mint& operator/=(const mint& other) {
-        *this *= fast_pow(other, MOD - 2);
-        return *this;
-    }
-    friend mint operator+(mint lhs, const mint& rhs) {
+    friend M operator+(M lhs, const M& rhs) {
         lhs += rhs;
         return lhs;
     }
-    friend mint operator-(mint lhs, const mint& rhs) {
+    friend M operator-(M lhs, const M& rhs) {
         lhs -= rhs;
         return lhs;
     }
-    friend mint operator*(mint lhs, const mint& rhs) {
+    friend M operator*(M lhs, const M& rhs) {
         lhs *= rhs;
         return lhs;
     }
-    friend mint operator/(mint lhs, const mint& rhs) {
+    friend M operator/(M lhs, const M& rhs) {
         lhs /= rhs;
         return lhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    mint& operator+=(T other) {
-        return *this += mint(static_cast<int64_t>(other));
+    M& operator+=(T other) {
+        return static_cast<M&>(*this) += M(static_cast<int64_t>(other));
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    mint& operator-=(T other) {
-        return *this -= mint(static_cast<int64_t>(other));
+    M& operator-=(T other) {
+        return static_cast<M&>(*this) -= M(static_cast<int64_t>(other));
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    mint& operator*=(T other) {
-        return *this *= mint(static_cast<int64_t>(other));
+    M& operator*=(T other) {
+        return static_cast<M&>(*this) *= M(static_cast<int64_t>(other));
     }
+    // small divisors covered by an already built Combinatorics<M> table skip the exponentiation
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    mint& operator/=(T other) {
-        return *this /= mint(static_cast<int64_t>(other));
+    M& operator/=(T other) {
+        M& self = static_cast<M&>(*this);
+        int64_t d = static_cast<int64_t>(other);
+        uint64_t ad = d < 0 ? 0 - uint64_t(d) : uint64_t(d);
+        if (ad != 0 && ad < Combinatorics<M>::size()) {
+            self *= Combinatorics<M>::inv(ad);
+            if (d < 0) self = M(0) - self;
+            return self;
+        }
+        return self /= M(d);
     }
 
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator+(mint lhs, T rhs) {
+    friend M operator+(M lhs, T rhs) {
         lhs += rhs;
         return lhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator-(mint lhs, T rhs) {
+    friend M operator-(M lhs, T rhs) {
         lhs -= rhs;
         return lhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator*(mint lhs, T rhs) {
+    friend M operator*(M lhs, T rhs) {
         lhs *= rhs;
         return lhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator/(mint lhs, T rhs) {
+    friend M operator/(M lhs, T rhs) {
         lhs /= rhs;
         return lhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator+(T lhs, mint rhs) {
+    friend M operator+(T lhs, M rhs) {
         rhs += lhs;
         return rhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator-(T lhs, mint rhs) {
-        return mint(lhs) - rhs;
+    friend M operator-(T lhs, M rhs) {
+        return M(lhs) - rhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator*(T lhs, mint rhs) {
+    friend M operator*(T lhs, M rhs) {
         rhs *= lhs;
         return rhs;
     }
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    friend mint operator/(T lhs, mint rhs) {
-        return mint(lhs) / rhs;
+    friend M operator/(T lhs, M rhs) {
+        return M(lhs) / rhs;
     }
-    friend mint operator<<(mint val, int64_t shift) {
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    friend M operator<<(M val, T shift) {
         if (shift < 0) return val >> (-shift);
-        return val * fast_pow(mint(2), shift);
+        return val * fast_pow(M(2), shift);
     }
-    friend mint operator>>(mint val, int64_t shift) {
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    friend M operator>>(M val, T shift) {
         if (shift < 0) return val << (-shift);
-        static const mint inv2 = fast_pow(mint(2), MOD - 2);
+        const M inv2 = M((int64_t(M::mod()) + 1) / 2);
         return val * fast_pow(inv2, shift);
     }
-    bool operator==(const mint& other) const {
-        return val == other.val;
-    }
-    bool operator!=(const mint& other) const {
-        return val != other.val;
+    bool operator!=(const M& other) const {
+        return !(static_cast<const M&>(*this) == other);
     }
-    bool operator>(const mint&) const {
+    bool operator>(const M&) const {
         undefined(); return false;
     }
-    bool operator>=(const mint&) const {
+    bool operator>=(const M&) const {
         undefined(); return false;
     }
-    bool operator<(const mint&) const {
+    bool operator<(const M&) const {
         undefined(); return false;
     }
-    bool operator<=(const mint&) const {
+    bool operator<=(const M&) const {
         undefined(); return false;
     }
-    friend std::ostream& operator<<(std::ostream& os, const mint& m) {
-        return os << m.val;
+    friend std::ostream& operator<<(std::ostream& os, const M& m) {
+        return os << m.value();
     }
-    friend std::istream& operator>>(std::istream& is, mint& m) {
+    friend std::istream& operator>>(std::istream& is, M& m) {
         int64_t x;
         is >> x;
-        m = mint(x);
+        m = M(x);
         return is;
     }
-    mint& operator++() { *this += 1; return *this; }
-    mint operator++(int32_t) { mint tmp = *this; ++(*this); return tmp; }
-    mint& operator--() { *this -= 1; return *this; }
-    mint operator--(int32_t) { mint tmp = *this; --(*this); return tmp; }
-    mint& operator%=(const mint&) { undefined(); return *this; }
-    friend mint operator%(mint, const mint&) { undefined(); return 0; }
+    M& operator++() { M& self = static_cast<M&>(*this); self += M(1); return self; }
+    M operator++(int32_t) { M tmp = static_cast<M&>(*this); ++(*this); return tmp; }
+    M& operator--() { M& self = static_cast<M&>(*this); self -= M(1); return self; }
+    M operator--(int32_t) { M tmp = static_cast<M&>(*this); --(*this); return tmp; }
+    M& operator%=(const M&) { undefined(); return static_cast<M&>(*this); }
+    friend M operator%(M, const M&) { undefined(); return M(0); }
+};
+
+template <uint32_t MOD>
+class static_mint : public mint_base<static_mint<MOD>> {
+private:
+    static_assert(MOD % 2 == 1 && MOD < (1u << 31), "Montgomery form needs an odd modulus below 2^31");
+
+    template <uint32_t> friend struct mint_kernels;
+
+    // Montgomery form: val = x * 2^32 mod MOD
+    uint32_t val;
+
+    static constexpr uint32_t inverse_mod_2_32() {
+        uint32_t inv = MOD;
+        for (int32_t i = 0; i < 5; ++i) inv *= 2 - MOD * inv;
+        return inv;
+    }
+    static constexpr uint32_t INV = inverse_mod_2_32();
+    static constexpr uint32_t R2 = uint32_t((0ull - uint64_t(MOD)) % MOD);
+
+    // returns t / 2^32 mod MOD for t < MOD * 2^32
+    static constexpr uint32_t reduce(uint64_t t) {
+        uint32_t m = uint32_t(t) * INV;
+        int32_t u = int32_t(uint32_t(t >> 32)) - int32_t(uint32_t((uint64_t(m) * MOD) >> 32));
+        return uint32_t(u < 0 ? u + int32_t(MOD) : u);
+    }
+
+public:
+    static constexpr uint32_t mod() { return MOD; }
+
+    static_mint() : val(0) { }
+    static_mint(int64_t x) {
+        int64_t r = x % int64_t(MOD);
+        if (r < 0) r += MOD;
+        val = reduce(uint64_t(r) * R2);
+    }
+    static_mint(const static_mint& other) = default;
+    ~static_mint() = default;
+    static_mint& operator=(const static_mint& other) = default;
+
+    uint32_t value() const { return reduce(val); }
+
+    static_mint& operator+=(const static_mint& other) {
+        val += other.val;
+        if (val >= MOD) val -= MOD;
+        return *this;
+    }
+    static_mint& operator-=(const static_mint& other) {
+        val = val >= other.val ? val - other.val : val + MOD - other.val;
+        return *this;
+    }
+    static_mint& operator*=(const static_mint& other) {
+        val = reduce(uint64_t(val) * other.val);
+        return *this;
+    }
+    using mint_base<static_mint<MOD>>::operator+=;
+    using mint_base<static_mint<MOD>>::operator-=;
+    using mint_base<static_mint<MOD>>::operator*=;
+    using mint_base<static_mint<MOD>>::operator/=;
+    bool operator==(const static_mint& other) const {
+        return val == other.val;
+    }
+};
+
+template <int32_t ID>
+class dynamic_mint : public mint_base<dynamic_mint<ID>> {
+private:
+    uint32_t val;
+
+    static inline uint32_t MOD = 998244353;
+    // Barrett constant ceil(2^64 / MOD)
+    static inline uint64_t INV = uint64_t(-1) / 998244353 + 1;
+
+    static uint32_t reduce(uint64_t z) {
+        uint64_t x = uint64_t((unsigned __int128)z * INV >> 64);
+        uint64_t y = x * MOD;
+        return uint32_t(z - y + (z < y ? MOD : 0));
+    }
+
+public:
+    static uint32_t mod() { return MOD; }
+    static void set_mod(uint32_t m) {
+        if (m < 1 || m >= (1u << 31)) throw std::invalid_argument("dynamic_mint: modulus must be in [1, 2^31)");
+        MOD = m;
+        INV = uint64_t(-1) / m + 1;
+    }
+
+    dynamic_mint() : val(0) { }
+    dynamic_mint(int64_t x) {
+        int64_t r = x % int64_t(MOD);
+        if (r < 0) r += MOD;
+        val = uint32_t(r);
+    }
+    dynamic_mint(const dynamic_mint& other) = default;
+    ~dynamic_mint() = default;
+    dynamic_mint& operator=(const dynamic_mint& other) = default;
+
+    uint32_t value() const { return val; }
+
+    dynamic_mint& operator+=(const dynamic_mint& other) {
+        val += other.val;
+        if (val >= MOD) val -= MOD;
+        return *this;
+    }
+    dynamic_mint& operator-=(const dynamic_mint& other) {
+        val = val >= other.val ? val - other.val : val + MOD - other.val;
+        return *this;
+    }
+    dynamic_mint& operator*=(const dynamic_mint& other) {
+        val = MOD == 1 ? 0 : reduce(uint64_t(val) * other.val);
+        return *this;
+    }
+    using mint_base<dynamic_mint<ID>>::operator+=;
+    using mint_base<dynamic_mint<ID>>::operator-=;
+    using mint_base<dynamic_mint<ID>>::operator*=;
+    using mint_base<dynamic_mint<ID>>::operator/=;
+    bool operator==(const dynamic_mint& other) const {
+        return val == other.val;
+    }
+};
+
+using mint = static_mint<998244353>;
+
+/*
+    Factorial tables for a modular integer type M: Combinatorics<mint>, Combinatorics<rmint>, ...
+
+    - fact(n), inv_fact(n), inv(n):  n!, 1/n!, 1/n
+    - C(n, k), P(n, k):             binomial coefficient and k-permutations of n (0 when k > n or k < 0)
+    - reserve(n):                   makes the tables cover [0, n]
+
+    The tables grow on demand (at least doubling), one inverse per growth: fact is extended
+    forward, then 1/fact[top] is found once and inv_fact is filled by a backward sweep,
+    inv_fact[i-1] = inv_fact[i] * i. After that every query is O(1).
+    They are rebuilt if a dynamic_mint modulus changes, and n must stay below the modulus.
+
+    Example Usage:
+        using comb = Combinatorics<mint>;
+        mint ways = comb::C(100000, 500) * comb::fact(20);
+        mint half = mint(7) / 2;    // uses comb::inv(2) once the table is built
+*/
+template <typename M>
+class Combinatorics {
+public:
+    static M fact(uint64_t n) { reserve(n); return table().fact[n]; }
+    static M inv_fact(uint64_t n) { reserve(n); return table().inv_fact[n]; }
+    static M inv(uint64_t n) {
+        if (n == 0) throw std::domain_error("Combinatorics::inv: zero has no inverse");
+        reserve(n);
+        return table().inv_fact[n] * table().fact[n - 1];
+    }
+    static M C(int64_t n, int64_t k) {
+        if (k < 0 || n < 0 || k > n) return M(0);
+        reserve(n);
+        const Table& t = table();
+        return t.fact[n] * t.inv_fact[k] * t.inv_fact[n - k];
+    }
+    static M P(int64_t n, int64_t k) {
+        if (k < 0 || n < 0 || k > n) return M(0);
+        reserve(n);
+        const Table& t = table();
+        return t.fact[n] * t.inv_fact[n - k];
+    }
+    // number of entries currently available, 0 if the modulus changed since the last build
+    static size_t size() {
+        const Table& t = table();
+        return t.mod == M::mod() ? t.fact.size() : 0;
+    }
+    static void reserve(uint64_t n) {
+        Table& t = table();
+        if (t.mod != M::mod()) {
+            t.fact.assign(1, M(1));
+            t.inv_fact.assign(1, M(1));
+            t.mod = M::mod();
+        }
+        if (n < t.fact.size()) return;
+        if (n >= M::mod()) throw std::out_of_range("Combinatorics: n must be below the modulus");
+        size_t old = t.fact.size();
+        size_t top = std::max<uint64_t>(n + 1, std::min<uint64_t>(2 * old, M::mod()));
+        t.fact.resize(top);
+        t.inv_fact.resize(top);
+        for (size_t i = old; i < top; ++i) t.fact[i] = t.fact[i - 1] * M(int64_t(i));
+        t.inv_fact[top - 1] = M(1) / t.fact[top - 1];
+        for (size_t i = top - 1; i > old; --i) t.inv_fact[i - 1] = t.inv_fact[i] * M(int64_t(i));
+    }
+
+private:
+    struct Table {
+        uint64_t mod = 0;
+        std::vector<M> fact, inv_fact;
+    };
+    static Table& table() {
+        static Table t;
+        return t;
+    }
 };
+
+/*
+    Batch operations over std::vector of modular integers.
+
+    - mul_batch(a, b):      a[i] *= b[i]
+    - add_batch(a, b):      a[i] += b[i]
+    - fma_batch(acc, a, b): acc[i] += a[i] * b[i]
+    - pow_batch(a, e):      a[i] = a[i]^e
+    - inv_batch(a):         a[i] = 1 / a[i], zeros stay zero
+
+    For static_mint the elementwise operations run on packed 32-bit Montgomery residues with
+    AVX-512 or AVX2 kernels, picked at run time from the CPU, and a scalar loop otherwise.
+    inv_batch uses Montgomery's trick, so n inverses cost one fast_pow and 3(n-1) multiplies.
+    Vector sizes must match, otherwise std::invalid_argument is thrown.
+
+    Example Usage:
+        std::vector<mint> a(n), b(n);
+        mul_batch(a, b);
+        inv_batch(a);
+        mint_batch_isa() = mint_isa::scalar; // force the portable path, e.g. for comparisons
+*/
+
+enum class mint_isa { scalar, avx2, avx512 };
+
+inline mint_isa detect_mint_isa() {
+#ifdef MINT_X86_SIMD
+    if (__builtin_cpu_supports("avx512f")) return mint_isa::avx512;
+    if (__builtin_cpu_supports("avx2")) return mint_isa::avx2;
+#endif
+    return mint_isa::scalar;
+}
+
+inline mint_isa& mint_batch_isa() {
+    static mint_isa isa = detect_mint_isa();
+    return isa;
+}
+
+// Raw kernels on Montgomery residues of static_mint<MOD>
+template <uint32_t MOD>
+struct mint_kernels {
+    using M = static_mint<MOD>;
+    static_assert(sizeof(M) == sizeof(uint32_t), "static_mint must be a bare 32-bit residue");
+
+    static uint32_t* raw(M* p) { return reinterpret_cast<uint32_t*>(p); }
+    static const uint32_t* raw(const M* p) { return reinterpret_cast<const uint32_t*>(p); }
+
+    static uint32_t mul(uint32_t a, uint32_t b) { return M::reduce(uint64_t(a) * b); }
+    static uint32_t add(uint32_t a, uint32_t b) { uint32_t s = a + b; return s >= MOD ? s - MOD : s; }
+
+#ifdef MINT_X86_SIMD
+    __attribute__((target("avx2"))) static __m256i mulhi_avx2(__m256i a, __m256i b) {
+        __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+        return _mm256_blend_epi32(even, odd, 0xAA);
+    }
+    __attribute__((target("avx2"))) static __m256i mul_avx2(__m256i a, __m256i b) {
+        __m256i m = _mm256_mullo_epi32(_mm256_mullo_epi32(a, b), _mm256_set1_epi32(int32_t(M::INV)));
+        __m256i u = _mm256_sub_epi32(mulhi_avx2(a, b), mulhi_avx2(m, _mm256_set1_epi32(int32_t(MOD))));
+        return _mm256_min_epu32(u, _mm256_add_epi32(u, _mm256_set1_epi32(int32_t(MOD))));
+    }
+    __attribute__((target("avx2"))) static __m256i add_avx2(__m256i a, __m256i b) {
+        __m256i s = _mm256_add_epi32(a, b);
+        return _mm256_min_epu32(s, _mm256_sub_epi32(s, _mm256_set1_epi32(int32_t(MOD))));
+    }
+
+    // GCC's AVX-512 headers trip -Wmaybe-uninitialized on their own _mm512_undefined_* temporaries
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    __attribute__((target("avx512f"))) static __m512i mulhi_avx512(__m512i a, __m512i b) {
+        __m512i even = _mm512_srli_epi64(_mm512_mul_epu32(a, b), 32);
+        __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+        return _mm512_mask_blend_epi32(0xAAAA, even, odd);
+    }
+    __attribute__((target("avx512f"))) static __m512i mul_avx512(__m512i a, __m512i b) {
+        __m512i m = _mm512_mullo_epi32(_mm512_mullo_epi32(a, b), _mm512_set1_epi32(int32_t(M::INV)));
+        const __m512i mod = _mm512_set1_epi32(int32_t(MOD));
+        __m512i u = _mm512_sub_epi32(mulhi_avx512(a, b), mulhi_avx512(m, mod));
+        return _mm512_mask_add_epi32(u, _mm512_cmplt_epi32_mask(u, _mm512_setzero_si512()), u, mod);
+    }
+    __attribute__((target("avx512f"))) static __m512i add_avx512(__m512i a, __m512i b) {
+        const __m512i mod = _mm512_set1_epi32(int32_t(MOD));
+        __m512i s = _mm512_add_epi32(a, b);
+        return _mm512_mask_sub_epi32(s, _mm512_cmpge_epu32_mask(s, mod), s, mod);
+    }
+
+    // op: 0 = mul, 1 = add, 2 = fma into a
+    template <int32_t OP>
+    __attribute__((target("avx2"))) static size_t run_avx2(uint32_t* a, const uint32_t* b, const uint32_t* c, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            if constexpr (OP == 0) x = mul_avx2(x, y);
+            if constexpr (OP == 1) x = add_avx2(x, y);
+            if constexpr (OP == 2) x = add_avx2(x, mul_avx2(y, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i))));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), x);
+        }
+        return i;
+    }
+    template <int32_t OP>
+    __attribute__((target("avx512f"))) static size_t run_avx512(uint32_t* a, const uint32_t* b, const uint32_t* c, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            if constexpr (OP == 0) x = mul_avx512(x, y);
+            if constexpr (OP == 1) x = add_avx512(x, y);
+            if constexpr (OP == 2) x = add_avx512(x, mul_avx512(y, _mm512_loadu_si512(c + i)));
+            _mm512_storeu_si512(a + i, x);
+        }
+        return i;
+    }
+    __attribute__((target("avx2"))) static size_t pow_avx2(uint32_t* a, uint64_t e, size_t n) {
+        size_t i = 0;
+        const __m256i one = _mm256_set1_epi32(int32_t(M(1).val));
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), r = one;
+            for (uint64_t y = e; y; y >>= 1, x = mul_avx2(x, x)) if (y & 1) r = mul_avx2(r, x);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), r);
+        }
+        return i;
+    }
+    __attribute__((target("avx512f"))) static size_t pow_avx512(uint32_t* a, uint64_t e, size_t n) {
+        size_t i = 0;
+        const __m512i one = _mm512_set1_epi32(int32_t(M(1).val));
+        for (; i + 16 <= n; i += 16) {
+            __m512i x = _mm512_loadu_si512(a + i), r = one;
+            for (uint64_t y = e; y; y >>= 1, x = mul_avx512(x, x)) if (y & 1) r = mul_avx512(r, x);
+            _mm512_storeu_si512(a + i, r);
+        }
+        return i;
+    }
+#pragma GCC diagnostic pop
+#endif
+
+    // returns how many leading elements were handled by a vector kernel
+    template <int32_t OP>
+    static size_t run(uint32_t* a, const uint32_t* b, const uint32_t* c, size_t n) {
+#ifdef MINT_X86_SIMD
+        if (mint_batch_isa() == mint_isa::avx512) return run_avx512<OP>(a, b, c, n);
+        if (mint_batch_isa() == mint_isa::avx2) return run_avx2<OP>(a, b, c, n);
+#endif
+        (void)a; (void)b; (void)c; (void)n;
+        return 0;
+    }
+    static size_t pow(uint32_t* a, uint64_t e, size_t n) {
+#ifdef MINT_X86_SIMD
+        if (mint_batch_isa() == mint_isa::avx512) return pow_avx512(a, e, n);
+        if (mint_batch_isa() == mint_isa::avx2) return pow_avx2(a, e, n);
+#endif
+        (void)a; (void)e; (void)n;
+        return 0;
+    }
+};
+
+template <typename M>
+struct is_static_mint : std::false_type {};
+template <uint32_t MOD>
+struct is_static_mint<static_mint<MOD>> : std::true_type {};
+
+template <typename M>
+void check_batch_sizes(const std::vector<M>& a, const std::vector<M>& b) {
+    if (a.size() != b.size()) throw std::invalid_argument("mint batch: vector sizes differ");
+}
+
+template <typename M>
+void mul_batch(std::vector<M>& a, const std::vector<M>& b) {
+    check_batch_sizes(a, b);
+    size_t i = 0;
+    if constexpr (is_static_mint<M>::value) {
+        using K = mint_kernels<M::mod()>;
+        i = K::template run<0>(K::raw(a.data()), K::raw(b.data()), nullptr, a.size());
+    }
+    for (; i < a.size(); ++i) a[i] *= b[i];
+}
+
+template <typename M>
+void add_batch(std::vector<M>& a, const std::vector<M>& b) {
+    check_batch_sizes(a, b);
+    size_t i = 0;
+    if constexpr (is_static_mint<M>::value) {
+        using K = mint_kernels<M::mod()>;
+        i = K::template run<1>(K::raw(a.data()), K::raw(b.data()), nullptr, a.size());
+    }
+    for (; i < a.size(); ++i) a[i] += b[i];
+}
+
+template <typename M>
+void fma_batch(std::vector<M>& acc, const std::vector<M>& a, const std::vector<M>& b) {
+    check_batch_sizes(acc, a);
+    check_batch_sizes(acc, b);
+    size_t i = 0;
+    if constexpr (is_static_mint<M>::value) {
+        using K = mint_kernels<M::mod()>;
+        i = K::template run<2>(K::raw(acc.data()), K::raw(a.data()), K::raw(b.data()), acc.size());
+    }
+    for (; i < acc.size(); ++i) acc[i] += a[i] * b[i];
+}
+
+template <typename M>
+void pow_batch(std::vector<M>& a, uint64_t e) {
+    size_t i = 0;
+    if constexpr (is_static_mint<M>::value) {
+        using K = mint_kernels<M::mod()>;
+        i = K::pow(K::raw(a.data()), e, a.size());
+    }
+    for (; i < a.size(); ++i) {
+        M x = a[i], r(1);
+        for (uint64_t y = e; y; y >>= 1, x *= x) if (y & 1) r *= x;
+        a[i] = r;
+    }
+}
+
+template <typename M>
+void inv_batch(std::vector<M>& a) {
+    size_t n = a.size();
+    if (n == 0) return;
+    std::vector<M> prefix(n);
+    M running(1);
+    for (size_t i = 0; i < n; ++i) {
+        prefix[i] = running;
+        if (a[i] != M(0)) running *= a[i];
+    }
+    M inv = M(1) / running;
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] == M(0)) continue;
+        M next = inv * a[i];
+        a[i] = inv * prefix[i];
+        inv = next;
+    }
+}
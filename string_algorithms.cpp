@@ -2,41 +2,323 @@
 #include <string>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <fstream>
+#include <string_view>
+#include <cstring>
+#include <climits>
+#include <functional>
+#include "instrumentation.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*
     @brief Computes the suffix array of the given string.
 
-    Appends a sentinel character and returns the starting indices of 
-    all suffixes in lexicographical order (excluding the sentinel).
+    Returns the starting indices of all suffixes in lexicographical order.
+
+    calculate() uses SA-IS (induced sorting), it works on any integer alphabet [0, upper]
+    and needs only O(N) extra memory, so it is the one to use on large texts.
+    calculate_parallel() is prefix doubling with parallel radix sorts over T threads.
+    calculate_doubling() is the older prefix doubling construction, kept for comparison.
+    save() writes the result to disk, StringAlgorithms::SuffixIndex maps it back with mmap.
+    Both also build the LCP array (Kasai, O(N)) and the inverse suffix array, which serve
+    get_difference(), lcp_query(), compare_substring() and count_unique_substrings().
 
-    @param s  Input string.
+    @param s  Input string (or vector of integers in [0, upper]).
 
     @return   A vector containing the lexicographically sorted suffix indices.
 
+    calculate():
+    Time complexity is O(N + upper), where N is the length of string
+    Space complexity is O(N + upper)
+
+    calculate_doubling():
     Time complexity is O(N*log(N)^2), where N is the length of string
     But, one of these "log"s is exact log, while other one comes from std::sort()
     Faster sorting algorithms can be used such as radix sort, for sorting a pair vector
     Of course, this version is fast enough almost always
-    Space complexity is O(N*log(N)), where N is the length of string
+    Space complexity is O(N), where N is the length of string
+
+    @fortesting
+    https://judge.yosupo.jp/problem/suffixarray
 */
 class StringAlgorithms{
 public:
     class SuffixArray{
     private:
-        std::vector<std::vector<int> >suff;
-        std::vector<std::vector<int> >ranks;
+        std::vector<int> sa, pos, lcp, text;
+        std::vector<std::vector<int> > sparse_table;
+
+        // s[i] in [0, upper], SA-IS as described by Nong, Zhang and Chan
+        static std::vector<int> sa_is(const std::vector<int>& s, int upper){
+            INSTRUMENT_DEPTH("suffix_array.sa_is");
+            int n = s.size();
+            if(n == 0) return {};
+            if(n == 1) return {0};
+            if(n == 2){
+                if(s[0] < s[1]) return {0, 1};
+                return {1, 0};
+            }
+            std::vector<int> result(n);
+            // ls[i] is true if suffix i is S-type (smaller than suffix i+1)
+            std::vector<bool> ls(n);
+            for(int i=n-2;i>=0;i--){
+                ls[i] = (s[i] == s[i+1]) ? ls[i+1] : (s[i] < s[i+1]);
+            }
+            // bucket starts, sum_l for L-type and sum_s for S-type suffixes of every character
+            std::vector<int> sum_l(upper+1), sum_s(upper+1);
+            for(int i=0;i<n;i++){
+                if(!ls[i]) sum_s[s[i]]++;
+                else sum_l[s[i]+1]++;
+            }
+            for(int i=0;i<=upper;i++){
+                sum_s[i] += sum_l[i];
+                if(i < upper) sum_l[i+1] += sum_s[i];
+            }
+            std::vector<int> buf(upper+1);
+            auto induce = [&](const std::vector<int>& lms){
+                std::fill(result.begin(), result.end(), -1);
+                std::copy(sum_s.begin(), sum_s.end(), buf.begin());
+                for(int d : lms){
+                    if(d == n) continue;
+                    result[buf[s[d]]++] = d;
+                }
+                std::copy(sum_l.begin(), sum_l.end(), buf.begin());
+                result[buf[s[n-1]]++] = n-1;
+                for(int i=0;i<n;i++){
+                    int v = result[i];
+                    if(v >= 1 && !ls[v-1]) result[buf[s[v-1]]++] = v-1;
+                }
+                std::copy(sum_l.begin(), sum_l.end(), buf.begin());
+                for(int i=n-1;i>=0;i--){
+                    int v = result[i];
+                    if(v >= 1 && ls[v-1]) result[--buf[s[v-1]+1]] = v-1;
+                }
+            };
+            std::vector<int> lms_map(n+1, -1), lms;
+            int m = 0;
+            for(int i=1;i<n;i++){
+                if(!ls[i-1] && ls[i]){
+                    lms_map[i] = m++;
+                    lms.push_back(i);
+                }
+            }
+            induce(lms);
+            if(m){
+                // name the sorted LMS substrings and sort them recursively
+                std::vector<int> sorted_lms, rec_s(m);
+                sorted_lms.reserve(m);
+                for(int v : result){
+                    if(lms_map[v] != -1) sorted_lms.push_back(v);
+                }
+                int rec_upper = 0;
+                rec_s[lms_map[sorted_lms[0]]] = 0;
+                for(int i=1;i<m;i++){
+                    int l = sorted_lms[i-1], r = sorted_lms[i];
+                    int end_l = (lms_map[l]+1 < m) ? lms[lms_map[l]+1] : n;
+                    int end_r = (lms_map[r]+1 < m) ? lms[lms_map[r]+1] : n;
+                    bool same = true;
+                    if(end_l - l != end_r - r){
+                        same = false;
+                    }
+                    else{
+                        while(l < end_l && s[l] == s[r]){
+                            l++;
+                            r++;
+                        }
+                        if(l == n || s[l] != s[r]) same = false;
+                    }
+                    if(!same) rec_upper++;
+                    rec_s[lms_map[sorted_lms[i]]] = rec_upper;
+                }
+                std::vector<int> rec_sa = sa_is(rec_s, rec_upper);
+                for(int i=0;i<m;i++){
+                    sorted_lms[i] = lms[rec_sa[i]];
+                }
+                induce(sorted_lms);
+            }
+            return result;
+        }
+        // sparse_table[k][i] = min(lcp[i], ..., lcp[i + 2^k - 1])
+        void build_sparse_table(){
+            int n = lcp.size();
+            sparse_table.assign(1, lcp);
+            for(int k=1;(1 << k) <= n;k++){
+                const std::vector<int>& prev = sparse_table[k-1];
+                std::vector<int> cur(n - (1 << k) + 1);
+                for(size_t i=0;i<cur.size();i++){
+                    cur[i] = std::min(prev[i], prev[i + (1 << (k-1))]);
+                }
+                sparse_table.push_back(std::move(cur));
+            }
+        }
+        // runs f(begin, end, t) over [0, n) split into contiguous blocks, one block per thread
+        template <typename F>
+        static void parallel_for(unsigned threads, size_t n, F f){
+            if(threads <= 1 || n < 2 * size_t(threads)){
+                f(size_t(0), n, 0u);
+                return;
+            }
+            std::vector<std::thread> pool;
+            size_t block = (n + threads - 1) / threads;
+            for(unsigned t=0;t<threads;t++){
+                size_t b = std::min(n, t * block), e = std::min(n, b + block);
+                pool.emplace_back(f, b, e, t);
+            }
+            for(std::thread& th : pool) th.join();
+        }
+        // stable LSD radix sort of a by key[a[i]], 11 bits per pass, per-thread histograms
+        static void parallel_radix_sort(std::vector<int>& a, std::vector<int>& buf, const std::vector<int>& key, int max_key, unsigned threads){
+            const int BITS = 11, B = 1 << BITS;
+            size_t n = a.size();
+            std::vector<size_t> hist(size_t(threads) * B);
+            for(int shift=0;shift < 31 && (shift == 0 || (max_key >> shift) > 0);shift += BITS){
+                std::fill(hist.begin(), hist.end(), 0);
+                parallel_for(threads, n, [&](size_t b, size_t e, unsigned t){
+                    size_t* h = hist.data() + size_t(t) * B;
+                    for(size_t i=b;i<e;i++) h[(key[a[i]] >> shift) & (B-1)]++;
+                });
+                size_t sum = 0;
+                for(int d=0;d<B;d++){
+                    for(unsigned t=0;t<threads;t++){
+                        size_t c = hist[size_t(t) * B + d];
+                        hist[size_t(t) * B + d] = sum;
+                        sum += c;
+                    }
+                }
+                parallel_for(threads, n, [&](size_t b, size_t e, unsigned t){
+                    size_t* h = hist.data() + size_t(t) * B;
+                    for(size_t i=b;i<e;i++) buf[h[(key[a[i]] >> shift) & (B-1)]++] = a[i];
+                });
+                a.swap(buf);
+            }
+        }
+        /*
+            Kasai et al., needs only text, sa and pos.
+            With several threads every block of starting positions runs its own Kasai
+            from h = 0, which costs at most one extra LCP length per block.
+        */
+        void build_lcp(unsigned threads = 1){
+            int n = text.size();
+            pos.assign(n, 0);
+            lcp.assign(n, 0);
+            parallel_for(threads, n, [&](size_t b, size_t e, unsigned){
+                for(size_t i=b;i<e;i++) pos[sa[i]] = i;
+            });
+            parallel_for(threads, n, [&](size_t b, size_t e, unsigned){
+                int h = 0;
+                for(int i=b;i<(int)e;i++){
+                    if(h > 0) h--;
+                    if(pos[i] == n-1){
+                        h = 0;
+                        continue;
+                    }
+                    int j = sa[pos[i]+1];
+                    while(i+h < n && j+h < n && text[i+h] == text[j+h]) h++;
+                    lcp[pos[i]] = h;
+                }
+            });
+            sparse_table.clear();
+        }
     public:
-        std::vector<int> calculate(std::string s){
+        std::vector<int> calculate(const std::string& s){
+            std::vector<int> v(s.size());
+            for(size_t i=0;i<s.size();i++){
+                v[i] = static_cast<unsigned char>(s[i]);
+            }
+            sa = sa_is(v, 255);
+            text = std::move(v);
+            build_lcp();
+            return sa;
+        }
+        std::vector<int> calculate(const std::vector<int>& s, int upper){
+            sa = sa_is(s, upper);
+            text = s;
+            build_lcp();
+            return sa;
+        }
+        /*
+            @brief Parallel suffix array construction.
+
+            Prefix doubling where every round is two stable parallel radix sorts
+            (by rank[i+k], then by rank[i]) and a parallel prefix sum for the new ranks,
+            stopping as soon as all ranks are distinct. The LCP array is built by blockwise Kasai.
+
+            @param s        Input string (or vector of integers in [0, upper]).
+            @param threads  Number of worker threads, 0 means std::thread::hardware_concurrency().
+
+            @return   Same result as calculate().
+
+            Time complexity is O(N*log(N)/T) per thread in the worst case (long repeats),
+            typical texts finish in a few rounds. Space complexity is O(N + T*2^11)
+        */
+        std::vector<int> calculate_parallel(const std::string& s, unsigned threads = 0){
+            std::vector<int> v(s.size());
+            parallel_for(std::max(1u, threads), s.size(), [&](size_t b, size_t e, unsigned){
+                for(size_t i=b;i<e;i++) v[i] = static_cast<unsigned char>(s[i]);
+            });
+            return calculate_parallel(v, 255, threads);
+        }
+        std::vector<int> calculate_parallel(const std::vector<int>& s, int upper, unsigned threads = 0){
+            if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            int n = s.size();
+            std::vector<int> rank(s), second(n, 0), next_rank(n), order(n), buf(n);
+            std::vector<int> block_count(threads + 1);
+            parallel_for(threads, n, [&](size_t b, size_t e, unsigned){
+                for(size_t i=b;i<e;i++) order[i] = i;
+            });
+            int max_rank = upper;
+            for(int k=0;n > 0;k = k ? 2*k : 1){
+                if(k){
+                    parallel_for(threads, n, [&](size_t b, size_t e, unsigned){
+                        for(size_t i=b;i<e;i++) second[i] = i+k < size_t(n) ? rank[i+k] + 1 : 0;
+                    });
+                    parallel_radix_sort(order, buf, second, max_rank + 1, threads);
+                }
+                parallel_radix_sort(order, buf, rank, max_rank, threads);
+                auto differs = [&](size_t i){
+                    return rank[order[i]] != rank[order[i-1]] || second[order[i]] != second[order[i-1]];
+                };
+                std::fill(block_count.begin(), block_count.end(), 0);
+                parallel_for(threads, n, [&](size_t b, size_t e, unsigned t){
+                    int c = 0;
+                    for(size_t i=std::max<size_t>(b, 1);i<e;i++) c += differs(i);
+                    block_count[t+1] = c;
+                });
+                for(unsigned t=0;t<threads;t++) block_count[t+1] += block_count[t];
+                parallel_for(threads, n, [&](size_t b, size_t e, unsigned t){
+                    int c = block_count[t];
+                    for(size_t i=b;i<e;i++){
+                        if(i > 0 && differs(i)) c++;
+                        next_rank[order[i]] = c;
+                    }
+                });
+                rank.swap(next_rank);
+                max_rank = rank[order[n-1]];
+                if(max_rank + 1 == n) break;
+            }
+            sa = std::move(order);
+            text = s;
+            build_lcp(threads);
+            return sa;
+        }
+        std::vector<int> calculate_doubling(std::string s){
             s.push_back('$');
             int n = s.length();
             int logn = ceil(log2(n));
             int gap, ord;
-            suff.resize(logn+1);
-            std::vector<std::pair<char,int> >init(n);
+            std::vector<std::pair<int,int> >init(n);
             std::vector<int>rank(n);
-            for(int i=0;i<n;i++){
-                init[i] = {s[i], i};
+            // the sentinel ranks below every byte, including ones smaller than '$'
+            for(int i=0;i<n-1;i++){
+                init[i] = {(unsigned char)s[i] + 1, i};
             }
+            init[n-1] = {0, n-1};
             std::sort(init.begin(), init.end());
             rank[init[0].second] = 0;
             ord = 0;
@@ -44,11 +326,6 @@ public:
                 if(init[i].first != init[i-1].first) ord++;
                 rank[init[i].second] = ord;
             }
-            suff[0].resize(n-1);
-            for(int i=0;i<n-1;i++){
-                suff[0][rank[i]-1] = i;
-            }
-            ranks.push_back(rank);
             for(int counter = 0; counter < logn; counter++){
                 gap = 1ll << counter;
                 std::vector<std::pair<std::pair<int,int>, int> >helper(n);
@@ -67,71 +344,307 @@ public:
                     if(helper[i].first != helper[i-1].first) ord++;
                     rank[helper[i].second] = ord;
                 }
-                suff[counter+1].resize(n-1);
-                for(int i=0;i<n-1;i++){
-                    suff[counter+1][rank[i]-1] = i;
-                }
-                ranks.push_back(rank);
             }
-            return suff.back();
+            sa.assign(n-1, 0);
+            for(int i=0;i<n-1;i++){
+                sa[rank[i]-1] = i;
+            }
+            text.assign(s.begin(), s.end() - 1);
+            build_lcp();
+            return sa;
         }
         /*
             @brief Computes the longest common prefix (LCP) lengths between
             adjacent suffixes in the suffix array.
 
-            Must be called after calculate(). Returns an array where each element 
-            represents the length of the common prefix between two consecutive 
-            suffixes in the sorted order.
+            Must be called after calculate() or calculate_doubling(). Returns an array where
+            element i is the length of the common prefix of suffixes sa[i] and sa[i+1];
+            the last element is 0.
 
             @return A vector of LCP values.
-            
-            Time complexity is O(N*log(N)), where N is the length of the string
-            Space complexity is O(N), where N is the length of the string
+
+            The array is built by Kasai's algorithm together with the suffix array,
+            so this is a copy: O(N) time and space, where N is the length of the string
         */
-        std::vector<int> get_difference(){
-            if(ranks.size() == 0) return {};
-            int n = suff[0].size();
-            std::vector<int>result(n);
-            int cur, next, ans;
-            for(int i=0;i<n-1;i++){
-                cur = suff.back()[i];
-                next = suff.back()[i+1];
-                ans = 0;
-                for(int j=ranks.size()-1;j>=0;j--){
-                    if(cur >= n or next >= n) break;
-                    if(ranks[j][cur] == ranks[j][next]){
-                        ans += 1ll << j;
-                        cur += 1ll << j;
-                        next += 1ll << j;
-                    }
-                }
-                result[i] = ans;
-            }
-            return result;
+        std::vector<int> get_difference() const {
+            return lcp;
+        }
+        // position of suffix i in the suffix array (inverse suffix array)
+        int rank_of(int i) const {
+            if(i < 0 || i >= (int)pos.size()) throw std::out_of_range("rank_of: invalid suffix index");
+            return pos[i];
+        }
+
+        /*
+            @brief Longest common prefix of the suffixes starting at i and j.
+
+            The first call builds a sparse table over the LCP array, O(N*log(N)) time and space,
+            after that every query is O(1).
+
+            @param i, j  Starting positions of the suffixes, zero-based.
+
+            @return Length of the longest common prefix.
+        */
+        int lcp_query(int i, int j){
+            int n = text.size();
+            if(i < 0 || j < 0 || i >= n || j >= n) throw std::out_of_range("lcp_query: invalid suffix index");
+            if(i == j) return n - i;
+            if(sparse_table.empty()) build_sparse_table();
+            int l = std::min(pos[i], pos[j]), r = std::max(pos[i], pos[j]);
+            int k = 31 - __builtin_clz(r - l);
+            return std::min(sparse_table[k][l], sparse_table[k][r - (1 << k)]);
+        }
+
+        /*
+            @brief Lexicographically compares substrings [i1..j1] and [i2..j2] of the text.
+
+            @return -1, 0 or +1, like Hash::compare_substring. O(1) after the first lcp_query().
+        */
+        int compare_substring(int i1, int j1, int i2, int j2){
+            int n = text.size();
+            if(i1 < 0 || j1 < i1 || j1 >= n || i2 < 0 || j2 < i2 || j2 >= n)
+                throw std::out_of_range("compare_substring: invalid substring range");
+            int len1 = j1 - i1 + 1, len2 = j2 - i2 + 1;
+            int common = std::min(lcp_query(i1, i2), std::min(len1, len2));
+            if(common == len1 && common == len2) return 0;
+            if(common == len1) return -1;
+            if(common == len2) return 1;
+            return text[i1 + common] < text[i2 + common] ? -1 : 1;
         }
-        
+
         /*
             @brief Computes the number of unique substrings (continuous subsequences) of a string
-            
+
             @param s  Input string.
-            
+
             @return Single integer, result
-            
-            Time and space complexity is O(N*log(N)), where N is the length of the string
-            
+
+            Time and space complexity is O(N), where N is the length of the string
+
             @fortesting
             https://atcoder.jp/contests/practice2/tasks/practice2_i
         */
-        
-        int count_unique_substrings(std::string s){
+
+        int64_t count_unique_substrings(const std::string& s){
             calculate(s);
-            std :: vector<int> v = get_difference();
-            int sum = 0, n = s.length();
-            for(int i=0;i<v.size();i++){
-                sum += v[i];
+            int64_t sum = 0, n = s.length();
+            for(size_t i=0;i<lcp.size();i++){
+                sum += lcp[i];
             }
             return n*(n+1)/2 - sum;
         }
+
+        /*
+            @brief Writes text, suffix array and LCP array to a binary index file,
+            to be opened later by SuffixIndex without rebuilding.
+
+            Must be called after one of the calculate functions, on a text whose
+            values fit in a byte (any std::string input does).
+
+            @param path  Output file, overwritten.
+
+            Throws std::logic_error if the text is not byte-valued, std::runtime_error on I/O errors.
+            Time and space complexity is O(N), where N is the length of the string
+        */
+        void save(const std::string& path) const {
+            static_assert(sizeof(int) == sizeof(int32_t), "index format stores 32-bit ints");
+            size_t n = text.size();
+            std::string bytes(n, '\0');
+            for(size_t i=0;i<n;i++){
+                if(text[i] < 0 || text[i] > 255) throw std::logic_error("save: text values must fit in a byte");
+                bytes[i] = static_cast<char>(text[i]);
+            }
+            IndexHeader header;
+            std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+            header.version = INDEX_VERSION;
+            header.byte_order = INDEX_BYTE_ORDER;
+            header.n = n;
+            header.text_offset = sizeof(IndexHeader);
+            header.sa_offset = align8(header.text_offset + n);
+            header.lcp_offset = header.sa_offset + align8(n * sizeof(int32_t));
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if(!out) throw std::runtime_error("save: cannot open " + path);
+            const char zeros[8] = {};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(bytes.data(), n);
+            out.write(zeros, header.sa_offset - header.text_offset - n);
+            out.write(reinterpret_cast<const char*>(sa.data()), n * sizeof(int32_t));
+            out.write(zeros, header.lcp_offset - header.sa_offset - n * sizeof(int32_t));
+            out.write(reinterpret_cast<const char*>(lcp.data()), n * sizeof(int32_t));
+            if(!out) throw std::runtime_error("save: write failed for " + path);
+        }
+    };
+
+    /*
+        On-disk suffix array index, version 1, native byte order:
+        header | text bytes | pad to 8 | int32 sa[n] | pad to 8 | int32 lcp[n]
+    */
+    struct IndexHeader{
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t n, text_offset, sa_offset, lcp_offset;
+    };
+    static constexpr char INDEX_MAGIC[8] = {'S', 'A', 'I', 'N', 'D', 'E', 'X', '\0'};
+    static constexpr uint32_t INDEX_VERSION = 1;
+    static constexpr uint32_t INDEX_BYTE_ORDER = 0x01020304;
+    static constexpr uint64_t align8(uint64_t x){
+        return (x + 7) & ~uint64_t(7);
+    }
+
+    /*
+        @class SuffixIndex
+        @brief Read-only view of a file written by SuffixArray::save(), mapped with mmap.
+
+        Opening costs O(1) besides header validation, the text, SA and LCP arrays are used
+        in place from the page cache, several processes share the same physical pages.
+
+        ➤ SuffixIndex(const std::string& path)
+          → Maps the file, throws std::runtime_error if it is missing, truncated,
+            or of another format / version / byte order.
+
+        ➤ std::string_view text() const, int suffix(size_t i) const, int lcp(size_t i) const
+          → The indexed text, i-th smallest suffix, LCP of suffix(i) and suffix(i+1).
+
+        ➤ std::pair<size_t, size_t> find(std::string_view pattern) const
+          → Range [l, r) of suffix array positions whose suffixes start with pattern.
+          → O(M*log(N)), where M is the length of pattern.
+
+        ➤ size_t count(std::string_view pattern) const, std::vector<int> occurrences(std::string_view pattern) const
+          → Number of occurrences / sorted starting positions of pattern.
+
+        ➤ int64_t count_unique_substrings() const
+          → Same as SuffixArray::count_unique_substrings, O(N).
+
+        Example:
+            StringAlgorithms::SuffixArray builder;
+            builder.calculate(corpus);
+            builder.save("corpus.sa");
+            StringAlgorithms::SuffixIndex index("corpus.sa");
+            size_t hits = index.count("needle");
+    */
+    class SuffixIndex{
+    private:
+        void* base = nullptr;
+        size_t mapped = 0;
+        const char* text_ptr = nullptr;
+        const int32_t* sa_ptr = nullptr;
+        const int32_t* lcp_ptr = nullptr;
+        size_t n = 0;
+
+        void release(){
+            if(base) munmap(base, mapped);
+            base = nullptr;
+            mapped = 0;
+        }
+        std::string_view prefix(size_t i, size_t m) const {
+            size_t p = sa_ptr[i];
+            return std::string_view(text_ptr + p, std::min(m, n - p));
+        }
+    public:
+        explicit SuffixIndex(const std::string& path){
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if(fd < 0) throw std::runtime_error("SuffixIndex: cannot open " + path);
+            struct stat st;
+            if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(IndexHeader)){
+                ::close(fd);
+                throw std::runtime_error("SuffixIndex: " + path + " is not an index file");
+            }
+            mapped = st.st_size;
+            base = mmap(nullptr, mapped, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(base == MAP_FAILED){
+                base = nullptr;
+                throw std::runtime_error("SuffixIndex: mmap failed for " + path);
+            }
+            IndexHeader header;
+            std::memcpy(&header, base, sizeof(header));
+            bool ok = std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0
+                   && header.version == INDEX_VERSION
+                   && header.byte_order == INDEX_BYTE_ORDER
+                   && header.n < uint64_t(INT32_MAX)
+                   && header.text_offset == sizeof(IndexHeader)
+                   && header.sa_offset == align8(header.text_offset + header.n)
+                   && header.lcp_offset == header.sa_offset + align8(header.n * sizeof(int32_t))
+                   && header.lcp_offset + header.n * sizeof(int32_t) <= mapped;
+            if(!ok){
+                release();
+                throw std::runtime_error("SuffixIndex: " + path + " has an unsupported format or is truncated");
+            }
+            const char* bytes = static_cast<const char*>(base);
+            n = header.n;
+            text_ptr = bytes + header.text_offset;
+            sa_ptr = reinterpret_cast<const int32_t*>(bytes + header.sa_offset);
+            lcp_ptr = reinterpret_cast<const int32_t*>(bytes + header.lcp_offset);
+        }
+        SuffixIndex(const SuffixIndex&) = delete;
+        SuffixIndex& operator=(const SuffixIndex&) = delete;
+        SuffixIndex(SuffixIndex&& other) noexcept{
+            *this = std::move(other);
+        }
+        SuffixIndex& operator=(SuffixIndex&& other) noexcept{
+            if(this != &other){
+                release();
+                std::swap(base, other.base);
+                std::swap(mapped, other.mapped);
+                text_ptr = other.text_ptr;
+                sa_ptr = other.sa_ptr;
+                lcp_ptr = other.lcp_ptr;
+                n = other.n;
+            }
+            return *this;
+        }
+        ~SuffixIndex(){
+            release();
+        }
+
+        size_t size() const {
+            return n;
+        }
+        std::string_view text() const {
+            return std::string_view(text_ptr, n);
+        }
+        int suffix(size_t i) const {
+            if(i >= n) throw std::out_of_range("suffix: invalid position");
+            return sa_ptr[i];
+        }
+        int lcp(size_t i) const {
+            if(i >= n) throw std::out_of_range("lcp: invalid position");
+            return lcp_ptr[i];
+        }
+        std::pair<size_t, size_t> find(std::string_view pattern) const {
+            size_t m = pattern.size(), lo = 0, hi = n;
+            while(lo < hi){
+                size_t mid = (lo + hi) / 2;
+                if(prefix(mid, m) < pattern) lo = mid + 1;
+                else hi = mid;
+            }
+            size_t l = lo;
+            hi = n;
+            while(lo < hi){
+                size_t mid = (lo + hi) / 2;
+                if(prefix(mid, m) == pattern) lo = mid + 1;
+                else hi = mid;
+            }
+            return {l, lo};
+        }
+        size_t count(std::string_view pattern) const {
+            std::pair<size_t, size_t> range = find(pattern);
+            return range.second - range.first;
+        }
+        std::vector<int> occurrences(std::string_view pattern) const {
+            std::pair<size_t, size_t> range = find(pattern);
+            std::vector<int> result(sa_ptr + range.first, sa_ptr + range.second);
+            std::sort(result.begin(), result.end());
+            return result;
+        }
+        int64_t count_unique_substrings() const {
+            int64_t sum = 0, len = n;
+            for(size_t i=0;i<n;i++){
+                sum += lcp_ptr[i];
+            }
+            return len*(len+1)/2 - sum;
+        }
     };
     SuffixArray suffixarray_obj;
 };
@@ -147,6 +660,7 @@ public:
 #include <cstdint>
 #include <utility>
 #include <algorithm>
+#include <string_view>
 
 /*
     @class Hash
@@ -169,15 +683,37 @@ public:
       → Returns the current number of strings stored in the object.
       → Example: if you pushed 3 strings, this returns 3.
     
-    ➤ int64_t push_back(std::string s)
+    ➤ Hash(storage_mode mode = storage_mode::owning)
+      → owning: pushed characters are copied into one contiguous pool.
+      → borrowed: only a std::string_view is kept, the caller must keep the characters alive.
+      → Either way prefix hashes of all strings share one flat array per modulus,
+        indexed by an offsets array, so a push costs no allocation besides amortized growth.
+
+    ➤ Hash(storage_mode mode, hash_mode hmode)
+      → hash_mode::double_mod (default): two random moduli from MODS, two % per substring hash.
+      → hash_mode::mersenne61: one hash mod 2^61-1 with a random base, reduced by shift and add,
+        collision probability about N/2^61 per comparison. get_pair splits the value so that
+        get_ll still returns first * 2^31 + second.
+
+    ➤ void reserve(size_t count, size_t total_length)
+      → Pre-sizes the flat arrays for count strings with total_length characters in total.
+
+    ➤ int64_t push_back(std::string_view s)
       → Adds a string to the hash system.
       → Computes and stores its prefix hashes.
       → Returns the 64-bit combined hash (based on its full content).
       → Example:
           int64_t h = hash.push_back("apple");
     
-    ➤ int64_t get_single(std::string s)
-      → Computes the 64-bit combined hash of the given string **without storing** it.
+    ➤ std::vector<int64_t> push_back_batch(const std::vector<std::string_view>& strs)
+      → Same as push_back on every string in order, returns their combined hashes.
+      → strs may contain views of strings already stored in this Hash (e.g. from get_view).
+      → Short strings are hashed 8 at a time in lockstep, strings of 256+ characters
+        (also in push_back) use a blocked builder: 8 chunks hashed together, then stitched
+        with the power tables. build_hash stays as the byte-at-a-time reference.
+
+    ➤ int64_t get_single(std::string_view s) const
+      → Computes the 64-bit combined hash of the given string **without storing** it, no allocation.
       → Useful for comparing with previously stored strings.
       → Example:
           int64_t h1 = hash.get_single("banana");
@@ -205,9 +741,14 @@ public:
     
     ➤ int64_t get_masked(size_t idx, int j) const
       → Returns the 64-bit combined hash when the character at position j is replaced by a wildcard.
-      → ⚠ Note: Requires alphabet_size to be increased by 1 (currently hardcoded to 26).
+      → Throws std::out_of_range on invalid index or position.
+      → The wildcard has a code of its own, distinct from all 256 byte values.
       → Example:
           int64_t masked = hash.get_masked(0, 2);  // first string, replacing s[2] with wildcard.
+
+    ➤ std::vector<int64_t> get_all_masked(size_t idx) const
+      → get_masked(idx, j) for every position j in one O(len) pass:
+        masked_j = full + (wildcard - s[j]) * base^(len-1-j), one multiply-add per position.
     
     ➤ int32_t compare_substring(int32_t idx1, int32_t i1, int32_t j1,
                                 int32_t idx2, int32_t i2, int32_t j2) const
@@ -218,9 +759,27 @@ public:
             0 if they are equal,
            +1 if first substring > second.
       → Uses binary search over hashes for efficiency.
+      → Bytes compare as unsigned char, the same order as std::string::compare
+        and SuffixArray::compare_substring, so "\x80" sorts after "a".
       → Example:
           int cmp = hash.compare_substring(0, 0, 2, 1, 0, 2);
     
+    ➤ void build_index(), int32_t find(std::string_view s) const, std::vector<int32_t> find_all(std::string_view s) const
+      → Open addressing table keyed by the combined hash over all stored strings, maintained
+        by later pushes and pops. find returns the newest equal string or -1, find_all all of them.
+
+    ➤ void build_window_index(size_t L), find_window(std::string_view pattern) const
+      → Snapshot index of every length-L substring, find_window returns (string index, position) pairs.
+
+    ➤ std::vector<std::pair<size_t, int32_t>> scan(std::string_view text) const
+      → Rabin-Karp over text with all stored strings as patterns, returns (position, string index).
+      → Example:
+          hash.push_back("he"); hash.push_back("she"); hash.build_index();
+          auto hits = hash.scan("ushers");  // {1, 1}, {2, 0}
+
+    ➤ std::string_view get_view(int32_t idx) const
+      → Returns a view of the stored string at index idx, no copy.
+
     ➤ std::string get_string(int32_t idx) const
       → Returns the original stored string at index idx.
       → Throws std::out_of_range on invalid index.
@@ -232,30 +791,219 @@ public:
     - This hash system is **not cryptographically secure**. It is designed for fast lookups,
       comparisons, and algorithmic use (e.g., pattern matching, deduplication).
     - Internally, strings are indexed zero-based.
-    - The alphabet_size is currently set to 26 ('a'..'z').
-      To support wildcard hash functions properly, increase it to 27.
+    - Strings are arbitrary bytes: every one of the 256 byte values is mapped to a random code
+      through a precomputed 256-entry table, so no input is out of range.
 */
 class Hash{
+public:
+    // owning: pushed strings are copied into one contiguous pool
+    // borrowed: only views are kept, the caller keeps the characters alive
+    enum class storage_mode { owning, borrowed };
+    // double_mod: two random 31-bit prime moduli, mersenne61: one modulus 2^61-1 with a random base
+    enum class hash_mode { double_mod, mersenne61 };
 private:
+    static constexpr uint64_t M61 = (1ull << 61) - 1;
     // 0 indexed
-    const int32_t alphabet_size = 26;
+    // every byte value has its own random code in [1, alphabet_size], the wildcard gets alphabet_size + 1
+    static constexpr int32_t alphabet_size = 256;
+    static constexpr int32_t WILDCARD = alphabet_size + 1;
     int32_t base1, base2, MOD1, MOD2, _string_count, max_string_length;
+    storage_mode mode;
+    hash_mode hmode;
+    uint64_t base61;
     std :: vector<int32_t> MODS = {998244353, 1000000007, 1000034507, 1000064501, 1009090909};
-    std :: vector<std :: vector<int32_t> > hash1, hash2;
+    // prefix hashes of string idx live in hash1/hash2[offsets[idx] .. offsets[idx+1])
+    std :: vector<int32_t> hash1, hash2;
+    std :: vector<uint64_t> hash61, pow61;
+    std :: vector<size_t> offsets;
     std :: vector<int32_t> pow1, pow2, shuffled_chars;
-    std :: vector<std::string> data;
+    // owning mode: characters at the same offsets, borrowed mode: one view per string
+    std :: string pool;
+    std :: vector<std :: string_view> views;
     std :: mt19937_64 rng;
-    int32_t calc_hash(const std :: vector<int32_t>& hash, const std :: vector<int32_t>& po, const size_t& i, const size_t& j, const int32_t& MOD) const {
+    /*
+        Open addressing (linear probing) map from a combined hash to the head of a chain.
+        Capacity is a power of two kept at most half full, erased keys leave a tombstone
+        until the next rehash.
+    */
+    struct open_table{
+        static constexpr int64_t EMPTY = -1, ERASED = -2;
+        std :: vector<uint64_t> keys;
+        std :: vector<int64_t> heads;
+        size_t used = 0;
+        static uint64_t mix(uint64_t k){
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdull;
+            return k ^ (k >> 33);
+        }
+        void clear(){
+            keys.clear();
+            heads.clear();
+            used = 0;
+        }
+        // slot holding key, or the empty slot that ends its probe sequence
+        size_t slot(uint64_t key) const {
+            size_t mask = keys.size() - 1, i = mix(key) & mask;
+            while(heads[i] != EMPTY && (heads[i] == ERASED || keys[i] != key)) i = (i + 1) & mask;
+            return i;
+        }
+        int64_t find(uint64_t key) const {
+            if(keys.empty()) return EMPTY;
+            return heads[slot(key)];
+        }
+        // sets the head of key to value and returns the previous head (EMPTY for a new key)
+        int64_t exchange(uint64_t key, int64_t value){
+            if(2 * (used + 1) > keys.size()) rehash(std :: max<size_t>(16, 2 * keys.size()));
+            size_t i = slot(key);
+            int64_t old = heads[i];
+            if(old == EMPTY) used++;
+            keys[i] = key;
+            heads[i] = value;
+            return old;
+        }
+        void erase(uint64_t key){
+            if(keys.empty()) return;
+            size_t i = slot(key);
+            if(heads[i] >= 0) heads[i] = ERASED;
+        }
+        void rehash(size_t capacity){
+            std :: vector<uint64_t> old_keys(capacity);
+            std :: vector<int64_t> old_heads(capacity, EMPTY);
+            old_keys.swap(keys);
+            old_heads.swap(heads);
+            used = 0;
+            for(size_t i=0;i<old_keys.size();i++){
+                if(old_heads[i] < 0) continue;
+                size_t j = slot(old_keys[i]);
+                keys[j] = old_keys[i];
+                heads[j] = old_heads[i];
+                used++;
+            }
+        }
+    };
+    // string index: chain of equal-hash strings, newest first
+    bool string_indexed = false;
+    open_table string_table;
+    std :: vector<int64_t> string_next;
+    std :: vector<size_t> length_count;
+    // window index: every length window_length substring, entries pack (idx << 32 | pos)
+    size_t window_length = 0;
+    open_table window_table;
+    std :: vector<uint64_t> window_entries;
+    std :: vector<int64_t> window_next;
+    void index_insert(size_t idx){
+        string_next.resize(idx + 1);
+        string_next[idx] = string_table.exchange(full_hash(idx), idx);
+        if(length(idx) >= length_count.size()) length_count.resize(length(idx) + 1);
+        length_count[length(idx)]++;
+    }
+    void index_erase_last(){
+        size_t idx = _string_count - 1;
+        if(string_next[idx] >= 0) string_table.exchange(full_hash(idx), string_next[idx]);
+        else string_table.erase(full_hash(idx));
+        string_next.pop_back();
+        length_count[length(idx)]--;
+    }
+    int32_t calc_hash(const int32_t* hash, const std :: vector<int32_t>& po, const size_t& i, const size_t& j, const int32_t& MOD) const {
         if(i==0) return hash[j];
         return ((hash[j] - int64_t(hash[i-1]) * po[j-i+1]) % MOD + MOD) % MOD;
     }
-    void build_hash(std :: vector<int32_t>& hash, std :: string& s, int MOD, int base){
-        assert(s.size() > 0);
-        hash[0] = shuffled_chars[s[0] - 'a'];
-        for(int i=1;i<s.length();i++){
-            hash[i] = (hash[i-1]*base + shuffled_chars[s[i] - 'a'])%MOD;
+    static uint64_t mul61(uint64_t a, uint64_t b){
+        __uint128_t p = (__uint128_t)a * b;
+        uint64_t r = (uint64_t(p) & M61) + uint64_t(p >> 61);
+        return r >= M61 ? r - M61 : r;
+    }
+    uint64_t calc_hash61(const uint64_t* hash, const size_t& i, const size_t& j) const {
+        if(i==0) return hash[j];
+        uint64_t r = hash[j] + M61 - mul61(hash[i-1], pow61[j-i+1]);
+        return r >= M61 ? r - M61 : r;
+    }
+    void build_hash61(uint64_t* hash, std :: string_view s) const {
+        uint64_t h = 0;
+        for(size_t i=0;i<s.length();i++){
+            h = mul61(h, base61) + code(s[i]);
+            if(h >= M61) h -= M61;
+            hash[i] = h;
+        }
+    }
+    void build_hash(int32_t* hash, std :: string_view s, int MOD, int base) const {
+        if(s.empty()) return;
+        hash[0] = code(s[0]);
+        for(size_t i=1;i<s.length();i++){
+            hash[i] = (int64_t(hash[i-1])*base + code(s[i]))%MOD;
+        }
+    }
+    /*
+        Reducers for the blocked / lockstep builders, mul_add(a, b, c) = (a * b + c) mod p.
+        barrett serves the 31-bit moduli with a multiply-high instead of a division,
+        mersenne serves 2^61-1 with shift and add.
+    */
+    struct barrett{
+        uint64_t mod, inv;
+        explicit barrett(uint64_t mod) : mod(mod), inv(~uint64_t(0) / mod) {}
+        uint64_t mul_add(uint64_t a, uint64_t b, uint64_t c) const {
+            uint64_t x = a * b + c;
+            uint64_t q = uint64_t((__uint128_t)x * inv >> 64);
+            uint64_t r = x - q * mod;
+            return r >= mod ? r - mod : r;
+        }
+    };
+    struct mersenne{
+        uint64_t mul_add(uint64_t a, uint64_t b, uint64_t c) const {
+            uint64_t r = mul61(a, b) + c;
+            return r >= M61 ? r - M61 : r;
+        }
+    };
+    static constexpr size_t LANES = 8;
+    static constexpr size_t BLOCKED_MIN_LENGTH = 256;
+    /*
+        Same result as the byte-at-a-time build_hash / build_hash61, but the string is cut into
+        LANES chunks whose local prefix hashes advance in lockstep (independent chains the CPU
+        overlaps), then chunk k is shifted by the global hash at the end of chunk k-1:
+        H[start + t] = H[start - 1] * pow[t + 1] + local[t], which has no loop-carried dependency.
+    */
+    template <typename T, typename R>
+    void build_hash_blocked(T* hash, std :: string_view s, uint64_t base, const T* po, const R& red) const {
+        size_t n = s.length(), chunk = (n + LANES - 1) / LANES;
+        uint64_t h[LANES] = {};
+        size_t full = n - (LANES - 1) * chunk;
+        for(size_t t=0;t<chunk;t++){
+            for(size_t k=0;k<LANES;k++){
+                if(k == LANES - 1 && t >= full) break;
+                size_t pos = k * chunk + t;
+                h[k] = red.mul_add(h[k], base, code(s[pos]));
+                hash[pos] = h[k];
+            }
+        }
+        for(size_t k=1;k<LANES;k++){
+            size_t start = k * chunk, end = std :: min(n, start + chunk);
+            uint64_t carry = hash[start - 1];
+            for(size_t t=start;t<end;t++){
+                hash[t] = red.mul_add(carry, uint64_t(po[t - start + 1]), hash[t]);
+            }
+        }
+    }
+    // prefix hashes of up to LANES strings at once, lane k walks strs[k]
+    template <typename T, typename R>
+    void build_hash_lockstep(T* const* out, const std :: string_view* strs, size_t count, uint64_t base, const R& red) const {
+        uint64_t h[LANES] = {};
+        size_t max_length = 0;
+        for(size_t k=0;k<count;k++) max_length = std :: max(max_length, strs[k].length());
+        for(size_t t=0;t<max_length;t++){
+            for(size_t k=0;k<count;k++){
+                if(t >= strs[k].length()) continue;
+                h[k] = red.mul_add(h[k], base, code(strs[k][t]));
+                out[k][t] = h[k];
+            }
         }
     }
+    int32_t single_hash(std :: string_view s, int MOD, int base) const {
+        int64_t h = 0;
+        for(char c : s){
+            h = (h*base + code(c))%MOD;
+        }
+        return h;
+    }
     void calculate_pows(std :: vector<int32_t>& po, int base, int MOD, int max_string_length){
         size_t old_length = po.size();
         po.resize(max_string_length);
@@ -263,6 +1011,25 @@ private:
             po[i] = int64_t(po[i-1])*base%MOD;
         }
     }
+    void grow_pows(size_t length){
+        while(length > size_t(max_string_length)){
+            max_string_length *= 2;
+            if(hmode == hash_mode::mersenne61){
+                size_t old_length = pow61.size();
+                pow61.resize(max_string_length);
+                for(size_t i=old_length;i<pow61.size();i++){
+                    pow61[i] = mul61(pow61[i-1], base61);
+                }
+            }
+            else{
+                calculate_pows(pow1, base1, MOD1, max_string_length);
+                calculate_pows(pow2, base2, MOD2, max_string_length);
+            }
+        }
+    }
+    int32_t code(char c) const {
+        return shuffled_chars[static_cast<unsigned char>(c)];
+    }
     void shuffle_chars(){
         shuffled_chars.resize(alphabet_size);
         for(int32_t i=0;i<alphabet_size;i++){
@@ -273,83 +1040,217 @@ private:
             std :: swap(shuffled_chars[i], shuffled_chars[i+j]);
         }
     }
+    size_t length(size_t idx) const {
+        return offsets[idx+1] - offsets[idx];
+    }
+    int64_t full_hash(size_t idx) const {
+        if(length(idx) == 0) return 0;
+        return sub_hash(idx, 0, length(idx) - 1);
+    }
+    // combined hash of [i..j] of string idx without bounds checks
+    int64_t sub_hash(size_t idx, size_t i, size_t j) const {
+        if(hmode == hash_mode::mersenne61) return calc_hash61(hash61.data() + offsets[idx], i, j);
+        return int64_t(calc_hash(hash1.data() + offsets[idx], pow1, i, j, MOD1)) * (1ll<<31)
+             + calc_hash(hash2.data() + offsets[idx], pow2, i, j, MOD2);
+    }
 public:
     size_t string_count() const {
         return _string_count;
     }
     std :: pair<int32_t,int32_t> get_pair(size_t idx, int32_t i, int32_t j) const {
-        if(idx >= hash1.size() or i < 0 or j >= hash1[idx].size()) 
+        if(idx >= size_t(_string_count) or i < 0 or j < i or size_t(j) >= length(idx))
             throw std::out_of_range("get_pair: idx=" + std::to_string(idx) + ", i=" + std::to_string(i) + ", j=" + std::to_string(j));
-        return {calc_hash(hash1[idx], pow1, i, j, MOD1), calc_hash(hash2[idx], pow2, i, j, MOD2)};
+        if(hmode == hash_mode::mersenne61){
+            // split so that get_ll's first * 2^31 + second gives back the 61-bit value
+            uint64_t h = calc_hash61(hash61.data() + offsets[idx], i, j);
+            return {int32_t(h >> 31), int32_t(h & ((1u << 31) - 1))};
+        }
+        return {calc_hash(hash1.data() + offsets[idx], pow1, i, j, MOD1), calc_hash(hash2.data() + offsets[idx], pow2, i, j, MOD2)};
     }
     int64_t get_ll(int idx, int i, int j) const {
         std :: pair<int64_t, int64_t>pa = get_pair(idx,i,j);
         return pa.first * (1ll<<31) + pa.second;
     }
-    int64_t push_back(std :: string s){
-        while(s.length() > max_string_length){
-            max_string_length *= 2;
-            calculate_pows(pow1, base1, MOD1, max_string_length);
-            calculate_pows(pow2, base2, MOD2, max_string_length);
-        }
-        std :: vector<int32_t>_hash1(s.length()), _hash2(s.length());
-        build_hash(_hash1, s, MOD1, base1);
-        build_hash(_hash2, s, MOD2, base2);
-        hash1.push_back(_hash1);
-        hash2.push_back(_hash2);
-        data.push_back(s);
+    int64_t push_back(std :: string_view s){
+        grow_pows(s.length());
+        size_t start = offsets.back();
+        bool blocked = s.length() >= BLOCKED_MIN_LENGTH;
+        if(hmode == hash_mode::mersenne61){
+            hash61.resize(start + s.length());
+            if(blocked) build_hash_blocked(hash61.data() + start, s, base61, pow61.data(), mersenne());
+            else build_hash61(hash61.data() + start, s);
+        }
+        else{
+            hash1.resize(start + s.length());
+            hash2.resize(start + s.length());
+            if(blocked){
+                build_hash_blocked(hash1.data() + start, s, base1, pow1.data(), barrett(MOD1));
+                build_hash_blocked(hash2.data() + start, s, base2, pow2.data(), barrett(MOD2));
+            }
+            else{
+                build_hash(hash1.data() + start, s, MOD1, base1);
+                build_hash(hash2.data() + start, s, MOD2, base2);
+            }
+        }
+        offsets.push_back(start + s.length());
+        if(mode == storage_mode::owning) pool.append(s.data(), s.length());
+        else views.push_back(s);
         ++_string_count;
-        return int64_t(_hash1.back()) * (1ll<<31)  + _hash2.back();
+        if(string_indexed) index_insert(_string_count - 1);
+        return full_hash(_string_count - 1);
     }
-    int64_t get_single(std :: string s){
-        while(s.length() > max_string_length){
-            max_string_length *= 2;
-            calculate_pows(pow1, base1, MOD1, max_string_length);
-            calculate_pows(pow2, base2, MOD2, max_string_length);
+    /*
+        Pushes every string of strs, same result as calling push_back on each in order.
+        Short strings are hashed LANES at a time in lockstep, long ones by the blocked builder.
+        Returns the combined hashes of the pushed strings.
+    */
+    std :: vector<int64_t> push_back_batch(const std :: vector<std :: string_view>& strs){
+        size_t total = 0, longest = 0;
+        for(std :: string_view s : strs){
+            total += s.length();
+            longest = std :: max(longest, s.length());
         }
-        std :: vector<int32_t>_hash1(s.length()), _hash2(s.length());
-        build_hash(_hash1, s, MOD1, base1);
-        build_hash(_hash2, s, MOD2, base2);
-        return int64_t(_hash1.back()) * (1ll<<31)  + _hash2.back();
+        grow_pows(longest);
+        // views into our own pool (re-pushing stored strings) are kept as offsets, reserve may move the pool
+        std :: vector<size_t> pool_offset;
+        if(mode == storage_mode::owning){
+            std :: less<const char*> before;
+            const char* pool_begin = pool.data();
+            const char* pool_end = pool_begin + pool.size();
+            for(size_t i=0;i<strs.size();i++){
+                if(!before(strs[i].data(), pool_begin) && before(strs[i].data(), pool_end)){
+                    if(pool_offset.empty()) pool_offset.assign(strs.size(), SIZE_MAX);
+                    pool_offset[i] = strs[i].data() - pool_begin;
+                }
+            }
+        }
+        reserve(_string_count + strs.size(), offsets.back() + total);
+        size_t first = _string_count;
+        for(size_t i=0;i<strs.size();i++){
+            offsets.push_back(offsets.back() + strs[i].length());
+            if(mode == storage_mode::owning){
+                bool own = !pool_offset.empty() && pool_offset[i] != SIZE_MAX;
+                pool.append(own ? pool.data() + pool_offset[i] : strs[i].data(), strs[i].length());
+            }
+            else views.push_back(strs[i]);
+        }
+        _string_count += strs.size();
+        if(hmode == hash_mode::mersenne61) hash61.resize(offsets.back());
+        else{
+            hash1.resize(offsets.back());
+            hash2.resize(offsets.back());
+        }
+        barrett red1(MOD1), red2(MOD2);
+        std :: string_view group[LANES];
+        int32_t* out1[LANES];
+        int32_t* out2[LANES];
+        uint64_t* out61[LANES];
+        size_t lanes = 0;
+        auto flush = [&](){
+            if(hmode == hash_mode::mersenne61){
+                build_hash_lockstep(out61, group, lanes, base61, mersenne());
+            }
+            else{
+                build_hash_lockstep(out1, group, lanes, base1, red1);
+                build_hash_lockstep(out2, group, lanes, base2, red2);
+            }
+            lanes = 0;
+        };
+        for(size_t i=0;i<strs.size();i++){
+            size_t start = offsets[first + i];
+            // hash the stored copy, the input view may point into the pool as it was before reserve
+            std :: string_view s = mode == storage_mode::owning ? std :: string_view(pool).substr(start, strs[i].length()) : strs[i];
+            if(s.length() >= BLOCKED_MIN_LENGTH){
+                if(hmode == hash_mode::mersenne61){
+                    build_hash_blocked(hash61.data() + start, s, base61, pow61.data(), mersenne());
+                }
+                else{
+                    build_hash_blocked(hash1.data() + start, s, base1, pow1.data(), red1);
+                    build_hash_blocked(hash2.data() + start, s, base2, pow2.data(), red2);
+                }
+                continue;
+            }
+            group[lanes] = s;
+            if(hmode == hash_mode::mersenne61) out61[lanes] = hash61.data() + start;
+            else{
+                out1[lanes] = hash1.data() + start;
+                out2[lanes] = hash2.data() + start;
+            }
+            if(++lanes == LANES) flush();
+        }
+        if(lanes) flush();
+        std :: vector<int64_t> result(strs.size());
+        for(size_t i=0;i<strs.size();i++){
+            result[i] = full_hash(first + i);
+            if(string_indexed) index_insert(first + i);
+        }
+        return result;
+    }
+    int64_t get_single(std :: string_view s) const {
+        if(hmode == hash_mode::mersenne61){
+            uint64_t h = 0;
+            for(char c : s){
+                h = mul61(h, base61) + code(c);
+                if(h >= M61) h -= M61;
+            }
+            return h;
+        }
+        return int64_t(single_hash(s, MOD1, base1)) * (1ll<<31) + single_hash(s, MOD2, base2);
     }
     int64_t pop_back(){
         if(_string_count == 0){
             throw std::out_of_range("pop_back : hash object is empty");
         }
-        int64_t to_be_ret = int64_t(hash1.back().back()) * (1ll<<31)  + hash2.back().back();
-        hash1.pop_back();
-        hash2.pop_back();
-        data.pop_back();
+        int64_t to_be_ret = full_hash(_string_count - 1);
+        if(string_indexed) index_erase_last();
+        window_length = 0;
+        offsets.pop_back();
+        if(hmode == hash_mode::mersenne61){
+            hash61.resize(offsets.back());
+        }
+        else{
+            hash1.resize(offsets.back());
+            hash2.resize(offsets.back());
+        }
+        if(mode == storage_mode::owning) pool.resize(offsets.back());
+        else views.pop_back();
         --_string_count;
         return to_be_ret;
     }
+    // full hash with position j replaced by the wildcard: full + (wildcard - s[j]) * base^(len-1-j)
+    int64_t masked_hash(size_t idx, size_t j, char c) const {
+        size_t rem = length(idx) - j - 1;
+        if(hmode == hash_mode::mersenne61){
+            uint64_t delta = WILDCARD + M61 - code(c);
+            return mersenne().mul_add(delta >= M61 ? delta - M61 : delta, pow61[rem], hash61[offsets[idx+1]-1]);
+        }
+        uint64_t m1 = barrett(MOD1).mul_add(WILDCARD + MOD1 - code(c), pow1[rem], hash1[offsets[idx+1]-1]);
+        uint64_t m2 = barrett(MOD2).mul_add(WILDCARD + MOD2 - code(c), pow2[rem], hash2[offsets[idx+1]-1]);
+        return int64_t(m1 << 31) | int64_t(m2);
+    }
     int64_t get_masked(size_t idx, int j) const {
-        // !!! If you will use this function, please increase alphabet_size by 1.
-        int len = hash1[idx].size();
-        int32_t pre1 = j > 0 ? calc_hash(hash1[idx], pow1, 0, j-1, MOD1) : 0;
-        int32_t pre2 = j > 0 ? calc_hash(hash2[idx], pow2, 0, j-1, MOD2) : 0;
-        int32_t suf1 = j+1 < len ? calc_hash(hash1[idx], pow1, j+1, len-1, MOD1) : 0;
-        int32_t suf2 = j+1 < len ? calc_hash(hash2[idx], pow2, j+1, len-1, MOD2) : 0;
-        int32_t w1 = shuffled_chars[alphabet_size - 1];
-        int32_t w2 = w1;
-        int rem = len - j - 1;
-        int64_t m1 = ( int64_t(pre1) * pow1[rem+1]
-                     + int64_t(w1)   * pow1[rem]
-                     + int64_t(suf1) ) % MOD1;
-        int64_t m2 = ( int64_t(pre2) * pow2[rem+1]
-                     + int64_t(w2)   * pow2[rem]
-                     + int64_t(suf2) ) % MOD2;
-        return (m1 << 31) | m2;
+        if(idx >= size_t(_string_count) or j < 0 or size_t(j) >= length(idx))
+            throw std::out_of_range("get_masked : invalid argument");
+        return masked_hash(idx, j, get_view(idx)[j]);
+    }
+    std :: vector<int64_t> get_all_masked(size_t idx) const {
+        if(idx >= size_t(_string_count)) throw std::out_of_range("get_all_masked : invalid string index");
+        std :: string_view s = get_view(idx);
+        std :: vector<int64_t> result(s.length());
+        for(size_t j=0;j<s.length();j++){
+            result[j] = masked_hash(idx, j, s[j]);
+        }
+        return result;
     }
     int32_t compare_substring(int32_t idx1, int32_t i1, int32_t j1, int32_t idx2, int32_t i2, int32_t j2) const{
         if (idx1 < 0 || idx1 >= _string_count || idx2 < 0 || idx2 >= _string_count)
             throw std::out_of_range("compare_substring: invalid string index");
-        if (i1 < 0 || j1 < i1 || j1 >= data[idx1].size() || i2 < 0 || j2 < i2 || j2 >= data[idx2].size())
+        if (i1 < 0 || j1 < i1 || size_t(j1) >= length(idx1) || i2 < 0 || j2 < i2 || size_t(j2) >= length(idx2))
             throw std::out_of_range("compare_substring: invalid substring range");
         int32_t right = std :: min(j1-i1+1, j2-i2+1), left = 1, lcp = 0, mid;
         while(left <= right){
             mid = (left + right) / 2;
-            if(get_pair(idx1, i1, i1+mid-1) == get_pair(idx2, i2, i2+mid-1)){
+            if(sub_hash(idx1, i1, i1+mid-1) == sub_hash(idx2, i2, i2+mid-1)){
                 lcp = std :: max(lcp, mid);
                 left = mid + 1;
             }
@@ -360,17 +1261,136 @@ public:
         if(i1 + lcp - 1 == j1 and i2 + lcp - 1 == j2) return 0;
         if(i1 + lcp - 1 == j1) return -1;
         if(i2 + lcp - 1 == j2) return 1;
-        if(data[idx1][i1+lcp] < data[idx2][i2+lcp]) return -1;
+        if((unsigned char)get_view(idx1)[i1+lcp] < (unsigned char)get_view(idx2)[i2+lcp]) return -1;
         return 1;
     }
+    /*
+        Hash index over the stored strings, kept up to date by push_back / push_back_batch / pop_back
+        once build_index() has been called. Candidates are verified character by character,
+        so results are exact.
+    */
+    void build_index(){
+        string_table.clear();
+        string_next.clear();
+        length_count.clear();
+        string_indexed = true;
+        for(int32_t idx=0;idx<_string_count;idx++){
+            index_insert(idx);
+        }
+    }
+    // index of the most recently pushed string equal to s, -1 if there is none
+    int32_t find(std :: string_view s) const {
+        if(!string_indexed) throw std::logic_error("find : call build_index() first");
+        for(int64_t h = string_table.find(get_single(s)); h >= 0; h = string_next[h]){
+            if(get_view(h) == s) return h;
+        }
+        return -1;
+    }
+    // indices of all stored strings equal to s, ascending
+    std :: vector<int32_t> find_all(std :: string_view s) const {
+        if(!string_indexed) throw std::logic_error("find_all : call build_index() first");
+        std :: vector<int32_t> result;
+        for(int64_t h = string_table.find(get_single(s)); h >= 0; h = string_next[h]){
+            if(get_view(h) == s) result.push_back(h);
+        }
+        std :: reverse(result.begin(), result.end());
+        return result;
+    }
+    /*
+        Indexes every substring of length L of every stored string.
+        This is a snapshot: strings pushed later are not included, pop_back drops it.
+    */
+    void build_window_index(size_t L){
+        if(L == 0) throw std::invalid_argument("build_window_index : L must be positive");
+        window_table.clear();
+        window_entries.clear();
+        window_next.clear();
+        for(int32_t idx=0;idx<_string_count;idx++){
+            for(size_t pos=0;pos+L<=length(idx);pos++){
+                window_next.push_back(window_table.exchange(sub_hash(idx, pos, pos+L-1), window_entries.size()));
+                window_entries.push_back(uint64_t(idx) << 32 | pos);
+            }
+        }
+        window_length = L;
+    }
+    // every (string index, position) where pattern occurs, pattern length must be the indexed L
+    std :: vector<std :: pair<int32_t, int32_t> > find_window(std :: string_view pattern) const {
+        if(window_length == 0 || pattern.length() != window_length)
+            throw std::logic_error("find_window : no window index of this length, call build_window_index()");
+        std :: vector<std :: pair<int32_t, int32_t> > result;
+        for(int64_t e = window_table.find(get_single(pattern)); e >= 0; e = window_next[e]){
+            int32_t idx = window_entries[e] >> 32, pos = window_entries[e] & 0xffffffffu;
+            if(get_view(idx).substr(pos, window_length) == pattern) result.push_back({idx, pos});
+        }
+        std :: sort(result.begin(), result.end());
+        return result;
+    }
+    /*
+        Multi-pattern search: the stored strings are the patterns. For every distinct pattern
+        length a rolling hash slides over text and probes the index at each window.
+        Returns every (position in text, string index) match, sorted.
+        Time complexity is O(|text| * D + matches), where D is the number of distinct lengths.
+    */
+    std :: vector<std :: pair<size_t, int32_t> > scan(std :: string_view text) const {
+        if(!string_indexed) throw std::logic_error("scan : call build_index() first");
+        std :: vector<std :: pair<size_t, int32_t> > result;
+        barrett red1(MOD1), red2(MOD2);
+        for(size_t L=1;L<length_count.size() && L<=text.length();L++){
+            if(length_count[L] == 0) continue;
+            uint64_t h1 = 0, h2 = 0;
+            for(size_t pos=0;pos+L<=text.length();pos++){
+                if(pos == 0){
+                    int64_t key = get_single(text.substr(0, L));
+                    h1 = hmode == hash_mode::mersenne61 ? uint64_t(key) : uint64_t(key) >> 31;
+                    h2 = uint64_t(key) & ((1u << 31) - 1);
+                }
+                else{
+                    uint64_t c_out = code(text[pos-1]), c_in = code(text[pos+L-1]);
+                    if(hmode == hash_mode::mersenne61){
+                        h1 = h1 + M61 - mul61(c_out, pow61[L-1]);
+                        if(h1 >= M61) h1 -= M61;
+                        h1 = mersenne().mul_add(h1, base61, c_in);
+                    }
+                    else{
+                        h1 = red1.mul_add(h1 + MOD1 - red1.mul_add(c_out, pow1[L-1], 0), base1, c_in);
+                        h2 = red2.mul_add(h2 + MOD2 - red2.mul_add(c_out, pow2[L-1], 0), base2, c_in);
+                    }
+                }
+                uint64_t key = hmode == hash_mode::mersenne61 ? h1 : h1 * (1ull<<31) + h2;
+                for(int64_t h = string_table.find(key); h >= 0; h = string_next[h]){
+                    if(length(h) == L && get_view(h) == text.substr(pos, L)) result.push_back({pos, int32_t(h)});
+                }
+            }
+        }
+        std :: sort(result.begin(), result.end());
+        return result;
+    }
+    std :: string_view get_view(int32_t idx) const{
+        if(idx < 0 or idx >= _string_count) throw std::out_of_range("get_view : invalid argument");
+        if(mode == storage_mode::owning) return std :: string_view(pool).substr(offsets[idx], length(idx));
+        return views[idx];
+    }
     std :: string get_string(int32_t idx) const{
         if(idx < 0 or idx >= _string_count) throw std::out_of_range("get_string : invalid argument");
-        return data[idx];
+        return std :: string(get_view(idx));
+    }
+    // pre-sizes the flat arrays for count strings of total_length characters
+    void reserve(size_t count, size_t total_length){
+        offsets.reserve(count + 1);
+        if(hmode == hash_mode::mersenne61){
+            hash61.reserve(total_length);
+        }
+        else{
+            hash1.reserve(total_length);
+            hash2.reserve(total_length);
+        }
+        if(mode == storage_mode::owning) pool.reserve(total_length);
+        else views.reserve(count);
     }
-    Hash() : rng(std::chrono::steady_clock::now().time_since_epoch().count()){
+    explicit Hash(storage_mode mode = storage_mode::owning, hash_mode hmode = hash_mode::double_mod) : mode(mode), hmode(hmode), rng(std::chrono::steady_clock::now().time_since_epoch().count()){
         shuffle_chars();
-        base1 = rng()%10 + alphabet_size + 1;
-        base2 = rng()%10 + alphabet_size + 1;
+        base1 = rng()%10 + WILDCARD + 1;
+        base2 = rng()%10 + WILDCARD + 1;
         if(base1 == base2) base2 = base1 + 1;
         MOD1 = rng() % MODS.size();
         MOD2 = rng() % MODS.size();
@@ -381,5 +1401,265 @@ public:
         max_string_length = 1;
         pow1.push_back(1);
         pow2.push_back(1);
+        pow61.push_back(1);
+        base61 = rng() % (M61 - (1ull << 32)) + (1ull << 31);
+        offsets.push_back(0);
+    }
+};
+
+
+#include <atomic>
+#include <memory>
+
+/*
+    @class ConcurrentHash
+    @brief Append-only rolling hash store that many threads can push to and query at the same time.
+
+    Same hashing as Hash with hash_mode::mersenne61 (one hash mod 2^61-1, random base,
+    random 256-entry byte codes), but laid out for concurrency:
+    - characters and prefix hashes go into fixed-size data segments, records into fixed-size
+      record segments; a segment never moves once allocated and is only freed by the destructor,
+    - the power table is built up to max_string_length in the constructor and never grows,
+    - a writer claims a record slot and a data range with atomic counters, fills them, marks the
+      record ready, then helps advance the published count over every consecutive ready record.
+
+    Readers only look at records below the published count, so get_pair, get_ll, get_view and
+    compare_substring are lock-free and never see partial data. Nothing can be popped.
+
+    ➤ ConcurrentHash(size_t max_string_length)
+      → Strings longer than max_string_length are rejected with std::length_error.
+
+    ➤ size_t append(std::string_view s)  /  int64_t push_back(std::string_view s)
+      → Thread-safe, lock-free append. append returns the string index, push_back its full hash.
+      → The string becomes visible to readers once every earlier index has been published too.
+      → If storing the string throws (capacity exceeded, bad_alloc), its index is still published,
+        holding an empty string, so appends after it are not held back.
+
+    ➤ size_t string_count() const
+      → Number of published strings.
+
+    ➤ get_pair, get_ll, get_single, get_view, compare_substring
+      → As in Hash, for published strings only (std::out_of_range otherwise).
+
+    Example:
+        ConcurrentHash store(1 << 16);
+        std::thread ingest([&]{ for(auto& key : keys) store.push_back(key); });
+        if(store.string_count() > 1) store.compare_substring(0, 0, 3, 1, 0, 3);   // from any thread
+*/
+class ConcurrentHash{
+private:
+    static constexpr uint64_t M61 = (1ull << 61) - 1;
+    static constexpr int32_t alphabet_size = 256;
+    static constexpr size_t RECORD_SEGMENT = 1 << 16;
+    static constexpr size_t MAX_SEGMENTS = 1 << 15;
+    struct Record{
+        uint64_t start;
+        uint32_t length;
+        std :: atomic<bool> ready;
+    };
+    struct RecordSegment{
+        Record records[RECORD_SEGMENT];
+    };
+    struct DataSegment{
+        std :: unique_ptr<char[]> chars;
+        std :: unique_ptr<uint64_t[]> hash;
+        explicit DataSegment(size_t capacity) : chars(new char[capacity]), hash(new uint64_t[capacity]) {}
+    };
+    size_t max_string_length, data_capacity;
+    uint64_t base61;
+    std :: vector<uint64_t> pow61;
+    std :: vector<int32_t> shuffled_chars;
+    std :: unique_ptr<std :: atomic<RecordSegment*>[]> record_segments;
+    std :: unique_ptr<std :: atomic<DataSegment*>[]> data_segments;
+    std :: atomic<size_t> next_index{0}, published{0};
+    std :: atomic<uint64_t> data_cursor{0};
+
+    static uint64_t mul61(uint64_t a, uint64_t b){
+        __uint128_t p = (__uint128_t)a * b;
+        uint64_t r = (uint64_t(p) & M61) + uint64_t(p >> 61);
+        return r >= M61 ? r - M61 : r;
+    }
+    int32_t code(char c) const {
+        return shuffled_chars[static_cast<unsigned char>(c)];
+    }
+    // returns the segment at slot i, allocating it if no other thread has yet
+    template <typename T, typename... Args>
+    static T* segment(std :: atomic<T*>* directory, size_t i, Args... args){
+        if(i >= MAX_SEGMENTS) throw std::length_error("ConcurrentHash : capacity exceeded");
+        T* seg = directory[i].load(std::memory_order_acquire);
+        if(seg) return seg;
+        T* fresh = new T(args...);
+        if(directory[i].compare_exchange_strong(seg, fresh, std::memory_order_acq_rel)) return fresh;
+        delete fresh;
+        return seg;
+    }
+    Record& record(size_t idx) const {
+        return record_segments[idx / RECORD_SEGMENT].load(std::memory_order_acquire)->records[idx % RECORD_SEGMENT];
+    }
+    const char* chars_at(uint64_t pos) const {
+        return data_segments[pos / data_capacity].load(std::memory_order_acquire)->chars.get() + pos % data_capacity;
+    }
+    const uint64_t* hash_at(uint64_t pos) const {
+        return data_segments[pos / data_capacity].load(std::memory_order_acquire)->hash.get() + pos % data_capacity;
+    }
+    // claims len characters that do not cross a data segment boundary
+    uint64_t claim(size_t len){
+        uint64_t pos = data_cursor.load(std::memory_order_relaxed), start;
+        do{
+            start = pos;
+            if(start % data_capacity + len > data_capacity) start = (start / data_capacity + 1) * data_capacity;
+        }while(!data_cursor.compare_exchange_weak(pos, start + len, std::memory_order_relaxed));
+        return start;
+    }
+    // seq_cst on ready and published: a writer that finishes last always sees the others' ready flags
+    void publish(){
+        size_t p = published.load();
+        while(p < next_index.load()){
+            RecordSegment* seg = record_segments[p / RECORD_SEGMENT].load();
+            if(!seg || !seg->records[p % RECORD_SEGMENT].ready.load()) break;
+            if(published.compare_exchange_weak(p, p + 1)) p++;
+        }
+    }
+    /*
+        idx was taken but its string could not be stored (capacity exceeded, bad_alloc).
+        Publishes it as an empty string so later appends still become visible. If even the
+        record segment cannot be allocated, idx stays unpublished, and so do the appends after it.
+    */
+    void abandon(size_t idx){
+        try{
+            Record& r = segment(record_segments.get(), idx / RECORD_SEGMENT)->records[idx % RECORD_SEGMENT];
+            r.start = 0;
+            r.length = 0;
+            r.ready.store(true);
+            publish();
+        }
+        catch(...){}
+    }
+    void check_index(size_t idx) const {
+        if(idx >= string_count()) throw std::out_of_range("ConcurrentHash : invalid string index");
+    }
+    uint64_t sub_hash(const Record& r, size_t i, size_t j) const {
+        const uint64_t* hash = hash_at(r.start);
+        if(i == 0) return hash[j];
+        uint64_t x = hash[j] + M61 - mul61(hash[i-1], pow61[j-i+1]);
+        return x >= M61 ? x - M61 : x;
+    }
+public:
+    explicit ConcurrentHash(size_t max_string_length)
+        : max_string_length(max_string_length), data_capacity(std :: max<size_t>(1 << 20, max_string_length)),
+          record_segments(new std :: atomic<RecordSegment*>[MAX_SEGMENTS]), data_segments(new std :: atomic<DataSegment*>[MAX_SEGMENTS]){
+        std :: mt19937_64 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+        shuffled_chars.resize(alphabet_size);
+        for(int32_t i=0;i<alphabet_size;i++){
+            shuffled_chars[i] = i+1;
+        }
+        std :: shuffle(shuffled_chars.begin(), shuffled_chars.end(), rng);
+        base61 = rng() % (M61 - (1ull << 32)) + (1ull << 31);
+        pow61.resize(max_string_length + 1);
+        pow61[0] = 1;
+        for(size_t i=1;i<pow61.size();i++){
+            pow61[i] = mul61(pow61[i-1], base61);
+        }
+        for(size_t i=0;i<MAX_SEGMENTS;i++){
+            record_segments[i].store(nullptr, std::memory_order_relaxed);
+            data_segments[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    ConcurrentHash(const ConcurrentHash&) = delete;
+    ConcurrentHash& operator=(const ConcurrentHash&) = delete;
+    ~ConcurrentHash(){
+        for(size_t i=0;i<MAX_SEGMENTS;i++){
+            delete record_segments[i].load(std::memory_order_relaxed);
+            delete data_segments[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t string_count() const {
+        return published.load(std::memory_order_acquire);
+    }
+    size_t append(std :: string_view s){
+        if(s.length() > max_string_length) throw std::length_error("ConcurrentHash : string longer than max_string_length");
+        size_t idx = next_index.fetch_add(1, std::memory_order_acq_rel);
+        RecordSegment* rseg;
+        DataSegment* dseg;
+        uint64_t start;
+        try{
+            rseg = segment(record_segments.get(), idx / RECORD_SEGMENT);
+            start = claim(s.length());
+            dseg = segment(data_segments.get(), start / data_capacity, data_capacity);
+        }
+        catch(...){
+            abandon(idx);
+            throw;
+        }
+        char* chars = dseg->chars.get() + start % data_capacity;
+        uint64_t* hash = dseg->hash.get() + start % data_capacity;
+        uint64_t h = 0;
+        for(size_t i=0;i<s.length();i++){
+            chars[i] = s[i];
+            h = mul61(h, base61) + code(s[i]);
+            if(h >= M61) h -= M61;
+            hash[i] = h;
+        }
+        Record& r = rseg->records[idx % RECORD_SEGMENT];
+        r.start = start;
+        r.length = s.length();
+        r.ready.store(true);
+        publish();
+        return idx;
+    }
+    int64_t push_back(std :: string_view s){
+        size_t idx = append(s);
+        const Record& r = record(idx);
+        return r.length ? hash_at(r.start)[r.length - 1] : 0;
+    }
+    int64_t get_single(std :: string_view s) const {
+        uint64_t h = 0;
+        for(char c : s){
+            h = mul61(h, base61) + code(c);
+            if(h >= M61) h -= M61;
+        }
+        return h;
+    }
+    std :: pair<int32_t,int32_t> get_pair(size_t idx, int32_t i, int32_t j) const {
+        int64_t h = get_ll(idx, i, j);
+        return {int32_t(h >> 31), int32_t(h & ((1u << 31) - 1))};
+    }
+    int64_t get_ll(size_t idx, int32_t i, int32_t j) const {
+        check_index(idx);
+        const Record& r = record(idx);
+        if(i < 0 or j < i or uint32_t(j) >= r.length)
+            throw std::out_of_range("get_ll: idx=" + std::to_string(idx) + ", i=" + std::to_string(i) + ", j=" + std::to_string(j));
+        return sub_hash(r, i, j);
+    }
+    std :: string_view get_view(size_t idx) const {
+        check_index(idx);
+        const Record& r = record(idx);
+        if(r.length == 0) return {};
+        return std :: string_view(chars_at(r.start), r.length);
+    }
+    int32_t compare_substring(size_t idx1, int32_t i1, int32_t j1, size_t idx2, int32_t i2, int32_t j2) const {
+        check_index(idx1);
+        check_index(idx2);
+        const Record& r1 = record(idx1);
+        const Record& r2 = record(idx2);
+        if (i1 < 0 || j1 < i1 || uint32_t(j1) >= r1.length || i2 < 0 || j2 < i2 || uint32_t(j2) >= r2.length)
+            throw std::out_of_range("compare_substring: invalid substring range");
+        int32_t right = std :: min(j1-i1+1, j2-i2+1), left = 1, lcp = 0, mid;
+        while(left <= right){
+            mid = (left + right) / 2;
+            if(sub_hash(r1, i1, i1+mid-1) == sub_hash(r2, i2, i2+mid-1)){
+                lcp = std :: max(lcp, mid);
+                left = mid + 1;
+            }
+            else{
+                right = mid - 1;
+            }
+        }
+        if(i1 + lcp - 1 == j1 and i2 + lcp - 1 == j2) return 0;
+        if(i1 + lcp - 1 == j1) return -1;
+        if(i2 + lcp - 1 == j2) return 1;
+        if((unsigned char)chars_at(r1.start)[i1+lcp] < (unsigned char)chars_at(r2.start)[i2+lcp]) return -1;
+        return 1;
     }
 };